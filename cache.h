@@ -0,0 +1,318 @@
+/**
+ * \file
+ * Read cache media decorator for slow (bus attached) media
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTCACHE_H
+#define PERSISTCACHE_H
+
+#include "media.h"
+
+
+namespace persist {
+
+/**
+ * A class offering a small LRU read cache in front of any media, itself a media so it stacks on any
+ * wrapper (or another decorator).  Reads are served from cache lines of LSZ Bytes, each holding one
+ * span of valid Bytes.  A miss reads only the Bytes missing from the line, so bus Bytes never exceed
+ * those of uncached reads.  Program, Write and Erase pass through and drop lines they cover.
+ *
+ * A cold \ref Struct::Load reads headers scanning forward then reads the newest slot again walking
+ * back, the header of that second read is served from cache.  Repeated loads and field reads of a
+ * cached slot need no media access.  Useful with SPI or I2C media where each read is a bus transaction,
+ * of no use with memory mapped on-chip flash.
+ *
+ * With \ref SetReadAhead a miss fills the whole line, a line spanning several slots serves the forward
+ * scan's headers and the newest slot from one read.  A cold load over 8 slots of 64 Bytes takes 2 reads
+ * instead of 8 but 512 Bytes instead of 136, on I2C at 400kHz about 11.7ms instead of 3.8ms.  Read ahead
+ * pays where the cost per transaction (driver call, chip select, DMA setup) exceeds that of the extra
+ * Bytes, fast SPI for example
+ *
+ * \code
+ * wrap::SpiNor g_nor(NorTransfer);
+ * persist::Cache<64, 4> g_cached(g_nor);
+ * persist::Struct<cfg_t> g_cfg_ps(g_cached, g_cached.GetStart(), 4);
+ * \endcode
+ *
+ * \note Media changed other than through the cache (another instance, another CPU) needs \ref Invalidate
+ * \tparam LSZ line size (Bytes), power of 2 and multiple of 4.  Media start must be LSZ aligned
+ * \tparam LINES line count, 1 to 255
+ */
+template<uint16_t LSZ, uint8_t LINES>
+class Cache : public Media {
+public:
+    /**
+     * Constructor
+     *
+     * \param[in,out] m media instance reference, cached media
+     */
+    Cache(Media &m) : media_(m), tick_(0), hits_(0), misses_(0), ahead_(false) {
+        Invalidate();
+    } // Cache(...)
+
+
+    /**
+     * Set read ahead, a miss reads the whole line rather than the Bytes missing
+     *
+     * \param[in] ahead true to read ahead
+     */
+    void SetReadAhead(const bool ahead) {
+        ahead_ = ahead;
+    } // SetReadAhead(...)
+
+
+    /**
+     * Drop all lines
+     */
+    void Invalidate() {
+        uint8_t i;
+
+        for(i = 0; i < LINES; i++) {
+            tag_[i] = TAG_NONE;
+            used_[i] = 0;
+            lo_[i] = hi_[i] = 0;
+        }
+    } // Invalidate()
+
+
+    /**
+     * Get reads served from cache without media access, counted per line
+     *
+     * \return N
+     */
+    uint32_t GetHits() const {
+        return hits_;
+    } // GetHits()
+
+
+    /**
+     * Get media reads filling lines
+     *
+     * \return N
+     */
+    uint32_t GetMisses() const {
+        return misses_;
+    } // GetMisses()
+
+
+    uint32_t GetPageSize() const {
+        return media_.GetPageSize();
+    }
+
+    uint32_t GetProgramSize() const {
+        return media_.GetProgramSize();
+    }
+
+    uint32_t GetSize() const {
+        return media_.GetSize();
+    }
+
+    uint32_t* const GetStart() const {
+        return media_.GetStart();
+    }
+
+    uint32_t* const GetEnd() const {
+        return media_.GetEnd();
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        uintptr_t p = media_.GetPageSize(), a = GetAddress(buffer) & ~(p - 1);
+
+        // Program may erase whole pages around buffer
+        Drop(a, GetAddress(buffer + size_u32) + p - 1 - a);
+
+        return media_.Program(buffer, data, size_u32, page_size_u32, use_lock);
+    } // Program(...)
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint8_t *d = reinterpret_cast<uint8_t*>(const_cast<uint32_t*>(data));
+        uintptr_t a = GetAddress(buffer), e = GetAddress(buffer + size_u32), n;
+        uint8_t i;
+        uint16_t j;
+        bool ok = true;
+
+        while(ok && a < e) {
+            n = LSZ - (a & (LSZ - 1));
+            if (n > e - a) {
+                n = e - a;
+            }
+
+            i = Fetch(a & ~static_cast<uintptr_t>(LSZ - 1), static_cast<uint16_t>(a & (LSZ - 1)),
+                        static_cast<uint16_t>((a & (LSZ - 1)) + n));
+            if (i < LINES) {
+                const uint8_t *l = reinterpret_cast<uint8_t*>(line_[i]) + (a & (LSZ - 1));
+
+                for(j = 0; j < n; j++) {
+                    d[j] = l[j];
+                }
+            }else {
+                // Line beyond media end, uncached
+                ok = media_.Read(GetLocation(a), reinterpret_cast<uint32_t*>(d), static_cast<int16_t>(n>>2));
+            }
+            a+= n;
+            d+= n;
+        }
+
+        return ok;
+    } // Read(...)
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return media_.Crc(buffer, size_u16);
+    }
+
+    const uint32_t* Map(const uint32_t *buffer) const {
+        return media_.Map(buffer);
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        Drop(GetAddress(buffer), static_cast<uintptr_t>(size_u32)<<2);
+
+        return media_.Write(buffer, data, size_u32);
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        Drop(GetAddress(buffer), static_cast<uintptr_t>(pages) * media_.GetPageSize());
+
+        return media_.Erase(buffer, pages);
+    } // Erase(...)
+
+    uint32_t GetEraseState() const {
+        return media_.GetEraseState();
+    }
+
+    bool NeedsErase() const {
+        return media_.NeedsErase();
+    }
+
+    uint32_t* GetImageEnd() const {
+        return media_.GetImageEnd();
+    }
+
+/*! \cond PRIVATE */
+protected:
+    static const uintptr_t TAG_NONE = ~static_cast<uintptr_t>(0);    // Never line aligned
+
+
+    static uintptr_t GetAddress(const uint32_t *buffer) {
+        return reinterpret_cast<uintptr_t>(buffer);
+    } // GetAddress(...)
+
+
+    static uint32_t* GetLocation(const uintptr_t address) {
+        return reinterpret_cast<uint32_t*>(address);
+    } // GetLocation(...)
+
+
+    /**
+     * Get line holding Bytes of media line address, reading those missing (whole line with read ahead).
+     * A line not cached takes the least recently used line.  A span not touching the valid span of the
+     * line replaces it
+     *
+     * \param[in] address line aligned media address
+     * \param[in] first first Byte within line, multiple of 4
+     * \param[in] last Byte after last within line, multiple of 4
+     * \return line index.  LINES when line not within media or read failed
+     */
+    uint8_t Fetch(const uintptr_t address, uint16_t first, uint16_t last) {
+        uint8_t i, lru = 0;
+        bool ok = true;
+
+        for(i = 0; i < LINES && tag_[i] != address; i++) {
+            if (used_[i] < used_[lru]) {
+                lru = i;
+            }
+        }
+
+        if (i == LINES && address >= GetAddress(media_.GetStart()) && address + LSZ <= GetAddress(media_.GetEnd())) {
+            i = lru;
+            tag_[i] = address;
+            lo_[i] = hi_[i] = ahead_ ? 0 : first;
+        }
+        if (i < LINES) {
+            if (first >= lo_[i] && last <= hi_[i]) {
+                hits_++;
+            }else {
+                if (ahead_) {
+                    first = 0;
+                    last = LSZ;
+                }
+                if (last < lo_[i] || first > hi_[i]) {
+                    lo_[i] = hi_[i] = first;
+                }
+                if (first < lo_[i]) {
+                    ok = Fill(i, first, lo_[i]);
+                    lo_[i] = first;
+                }
+                if (ok && last > hi_[i]) {
+                    ok = Fill(i, hi_[i], last);
+                    hi_[i] = last;
+                }
+            }
+
+            if (ok) {
+                used_[i] = ++tick_;
+            }else {
+                tag_[i] = TAG_NONE;
+                used_[i] = 0;
+                i = LINES;
+            }
+        }
+
+        return i;
+    } // Fetch(...)
+
+
+    /**
+     * Read Bytes of line from media
+     *
+     * \param[in] i line index
+     * \param[in] first first Byte within line, multiple of 4
+     * \param[in] last Byte after last within line, multiple of 4
+     * \retval true read
+     * \retval false read failed
+     */
+    bool Fill(const uint8_t i, const uint16_t first, const uint16_t last) {
+        misses_++;
+
+        return media_.Read(GetLocation(tag_[i] + first), line_[i] + (first>>2), static_cast<int16_t>((last - first)>>2));
+    } // Fill(...)
+
+
+    /**
+     * Drop lines overlapping media range
+     *
+     * \param[in] address media address
+     * \param[in] bytes range size
+     */
+    void Drop(const uintptr_t address, const uintptr_t bytes) {
+        uint8_t i;
+
+        for(i = 0; i < LINES; i++) {
+            if (tag_[i] != TAG_NONE && tag_[i] + LSZ > address && tag_[i] < address + bytes) {
+                tag_[i] = TAG_NONE;
+                used_[i] = 0;
+            }
+        }
+    } // Drop(...)
+
+
+protected:
+    Media       &media_;
+    uint32_t    line_[LINES][LSZ>>2];
+    uintptr_t   tag_[LINES];        // Media address of line
+    uint16_t    lo_[LINES];         // Valid span of line, Bytes
+    uint16_t    hi_[LINES];
+    uint32_t    used_[LINES];       // Tick of last use, LRU is lowest
+    uint32_t    tick_;
+    uint32_t    hits_;
+    uint32_t    misses_;
+    bool        ahead_;             // Read ahead, miss fills whole line
+/*! \endcond */
+}; // class Cache
+
+} // namespace persist
+
+#endif // PERSISTCACHE_H
@@ -0,0 +1,264 @@
+/**
+ * \file
+ * Write combining media decorator for small programs sharing a media unit
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTCOMBINE_H
+#define PERSISTCOMBINE_H
+
+#include "media.h"
+
+
+namespace persist {
+
+/**
+ * A class offering write combining in front of any media, itself a media so it stacks on any wrapper
+ * (or another decorator).  Programs within one unit of USZ Bytes are gathered in a RAM copy of the unit
+ * and reach media as one program per run of media pages changed.  Changed pages are programmed:
+ * - on \ref Flush
+ * - by a program to another unit, or one not fitting the unit
+ * - before any Write or Erase
+ *
+ * Reads within the unit are served from the copy, which is kept after a flush.  A page saved many times
+ * between flushes (a structure saved per field edit, several structures of a \ref Group) reaches media
+ * once with its last content rather than once per save, each otherwise being its own read, compare,
+ * write and verify on bus attached media.
+ *
+ * \code
+ * persist::Combine<256> g_combined(g_fram);    // 4 of 64 Byte media pages
+ * persist::Struct<net_t> g_net_ps(g_combined, g_combined.GetStart(), 2);
+ * persist::Struct<cred_t> g_cred_ps(g_combined, g_combined.GetStart() + (128>>2), 2);
+ *
+ * g_net_ps.Save(net);
+ * g_cred_ps.Save(cred);
+ * g_combined.Flush();
+ * \endcode
+ *
+ * \attention A program returns true once combined, media failure is reported by the \ref Flush (or
+ * program) that programs the unit.  Saves not flushed are lost at power down
+ * \note Media pages larger than USZ, not dividing it or more than 32 per unit are not combined, programs
+ * pass through.  Media changed other than through the decorator needs a Write, Erase or new instance
+ * \tparam USZ unit size (Bytes), power of 2 and multiple of media page size
+ */
+template<uint16_t USZ>
+class Combine : public Media {
+public:
+    /**
+     * Constructor
+     *
+     * \param[in,out] m media instance reference, combined media
+     */
+    Combine(Media &m) : media_(m), unit_(UNIT_NONE), dirty_(0), page_size_u32_(0), use_lock_(false),
+                programs_(0), combined_(0) {
+        page_ = media_.GetPageSize();
+        combine_ = page_ && page_ <= USZ && !(USZ % page_) && USZ / page_ <= 32;
+    } // Combine(...)
+
+
+    /**
+     * Program changed pages of unit to media, one program per run of changed pages
+     *
+     * \retval true on success or nothing to program
+     * \retval false media program failed, unit is dropped
+     */
+    bool Flush() {
+        uint32_t first, last, n = USZ / page_;
+        bool done = true;
+
+        // Whole media pages, erase media loses the rest of a page otherwise
+        for(first = 0; done && dirty_ && first < n; first = last) {
+            for(; first < n && !(dirty_ & (1UL << first)); first++);
+            for(last = first; last < n && (dirty_ & (1UL << last)); last++);
+            if (first < last) {
+                done = media_.Program(GetLocation(unit_ + first * page_), buffer_ + ((first * page_)>>2),
+                                        static_cast<int16_t>(((last - first) * page_)>>2), page_size_u32_, use_lock_);
+                programs_++;
+            }
+        }
+        dirty_ = 0;
+        if (!done) {
+            unit_ = UNIT_NONE;
+        }
+
+        return done;
+    } // Flush()
+
+
+    /**
+     * Get programs issued to media
+     *
+     * \return N
+     */
+    uint32_t GetPrograms() const {
+        return programs_;
+    } // GetPrograms()
+
+
+    /**
+     * Get programs gathered into a unit
+     *
+     * \return N
+     */
+    uint32_t GetCombined() const {
+        return combined_;
+    } // GetCombined()
+
+
+    uint32_t GetPageSize() const {
+        return media_.GetPageSize();
+    }
+
+    uint32_t GetProgramSize() const {
+        return media_.GetProgramSize();
+    }
+
+    uint32_t GetSize() const {
+        return media_.GetSize();
+    }
+
+    uint32_t* const GetStart() const {
+        return media_.GetStart();
+    }
+
+    uint32_t* const GetEnd() const {
+        return media_.GetEnd();
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        uintptr_t a = GetAddress(buffer), u = a & ~static_cast<uintptr_t>(USZ - 1), o = a - u;
+        uint16_t i;
+        bool done;
+
+        if (combine_ && size_u32 > 0 && o + (static_cast<uintptr_t>(size_u32)<<2) <= USZ && \
+                u >= GetAddress(media_.GetStart()) && u + USZ <= GetAddress(media_.GetEnd())) {
+            done = (u == unit_ || Flush()) && Fetch(u);
+            if (done) {
+                for(i = 0; i < size_u32; i++) {
+                    buffer_[(o>>2) + i] = data[i];
+                }
+                for(i = static_cast<uint16_t>(o / page_); i <= (o + (size_u32<<2) - 1) / page_; i++) {
+                    dirty_|= 1UL << i;
+                }
+                page_size_u32_ = page_size_u32;
+                use_lock_ = use_lock;
+                combined_++;
+            }
+        }else {
+            programs_++;
+            done = Flush();
+            unit_ = UNIT_NONE;
+            done = done && media_.Program(buffer, data, size_u32, page_size_u32, use_lock);
+        }
+
+        return done;
+    } // Program(...)
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint32_t *d = const_cast<uint32_t*>(data);
+        uintptr_t a = GetAddress(buffer);
+        int16_t i;
+        bool ok;
+
+        if (unit_ != UNIT_NONE && a >= unit_ && a + (static_cast<uintptr_t>(size_u32)<<2) <= unit_ + USZ) {
+            for(i = 0; i < size_u32; i++) {
+                d[i] = buffer_[((a - unit_)>>2) + i];
+            }
+            ok = true;
+        }else {
+            ok = media_.Read(buffer, data, size_u32);
+            for(i = 0; ok && unit_ != UNIT_NONE && i < size_u32; i++, a+= sizeof(uint32_t)) {
+                if (a >= unit_ && a < unit_ + USZ) {
+                    d[i] = buffer_[(a - unit_)>>2];
+                }
+            }
+        }
+
+        return ok;
+    } // Read(...)
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return media_.Crc(buffer, size_u16);
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        bool done = Flush();
+
+        unit_ = UNIT_NONE;
+
+        return done && media_.Write(buffer, data, size_u32);
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        bool done = Flush();
+
+        unit_ = UNIT_NONE;
+
+        return done && media_.Erase(buffer, pages);
+    } // Erase(...)
+
+    uint32_t GetEraseState() const {
+        return media_.GetEraseState();
+    }
+
+    bool NeedsErase() const {
+        return media_.NeedsErase();
+    }
+
+    uint32_t* GetImageEnd() const {
+        return media_.GetImageEnd();
+    }
+
+/*! \cond PRIVATE */
+protected:
+    static const uintptr_t UNIT_NONE = ~static_cast<uintptr_t>(0);   // Never unit aligned
+
+
+    static uintptr_t GetAddress(const uint32_t *buffer) {
+        return reinterpret_cast<uintptr_t>(buffer);
+    } // GetAddress(...)
+
+
+    static uint32_t* GetLocation(const uintptr_t address) {
+        return reinterpret_cast<uint32_t*>(address);
+    } // GetLocation(...)
+
+
+    /**
+     * Make unit the combined unit, reading it from media when not already.  Previous unit flushed
+     *
+     * \param[in] address unit aligned media address
+     * \retval true unit in RAM copy
+     * \retval false media read failed
+     */
+    bool Fetch(const uintptr_t address) {
+        bool ok = true;
+
+        if (unit_ != address) {
+            ok = media_.Read(GetLocation(address), buffer_, static_cast<int16_t>(USZ>>2));
+            unit_ = ok ? address : UNIT_NONE;
+        }
+
+        return ok;
+    } // Fetch(...)
+
+
+protected:
+    Media       &media_;
+    uint32_t    buffer_[USZ>>2];    // RAM copy of unit
+    uintptr_t   unit_;              // Media address of unit
+    uint32_t    dirty_;             // Changed pages of unit, bit per page
+    uint32_t    page_;              // Media page, Bytes
+    uint32_t    page_size_u32_;     // Last program arguments
+    bool        use_lock_;
+    bool        combine_;
+    uint32_t    programs_;
+    uint32_t    combined_;
+/*! \endcond */
+}; // class Combine
+
+} // namespace persist
+
+#endif // PERSISTCOMBINE_H
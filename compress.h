@@ -0,0 +1,531 @@
+/**
+ * \file
+ * Persistent structure stored compressed
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTCOMPRESS_H
+#define PERSISTCOMPRESS_H
+
+#include "struct.h"
+
+
+namespace persist {
+
+/**
+ * Run length codec (PackBits style).  No state or working memory so suitable for small MCUs.
+ * Control byte c followed by:
+ *   c <  128, literal run of c+1 bytes
+ *   c >= 128, single byte repeated c-125 times (3 to 130)
+ */
+class Rle {
+public:
+    /**
+     * Compress source into destination
+     *
+     * \param[in] src source data
+     * \param[in] src_len source length (Bytes)
+     * \param[out] dst destination
+     * \param[in] dst_max destination size (Bytes)
+     * \return Compressed length (Bytes) or 0 when it won't fit destination
+     */
+    static uint32_t Encode(const uint8_t *src, const uint32_t src_len, uint8_t *dst, const uint32_t dst_max) {
+        uint32_t i = 0, o = 0, r, l;
+
+        while(i < src_len) {
+            // Repeat run at i?
+            for(r = 1; (i + r) < src_len && r < 130 && src[i + r] == src[i]; r++) { }
+
+            if (r >= 3) {
+                if ((o + 2) > dst_max) {
+                    return 0;
+                }
+                dst[o++] = static_cast<uint8_t>(r + 125);
+                dst[o++] = src[i];
+                i+= r;
+            }else {
+                // Literal run until next repeat of 3 or more
+                for(l = 1; (i + l) < src_len && l < 128; l++) {
+                    if ((i + l + 2) < src_len && src[i + l] == src[i + l + 1] && src[i + l] == src[i + l + 2]) {
+                        break;
+                    }
+                }
+                if ((o + 1 + l) > dst_max) {
+                    return 0;
+                }
+                dst[o++] = static_cast<uint8_t>(l - 1);
+                for(r = 0; r < l; r++) {
+                    dst[o++] = src[i++];
+                }
+            }
+        }
+
+        return o;
+    } // Encode(...)
+
+
+    /**
+     * Decompress source into destination
+     *
+     * \param[in] src compressed data
+     * \param[in] src_len compressed length (Bytes)
+     * \param[out] dst destination
+     * \param[in] dst_len expected decompressed length (Bytes)
+     * \retval true success
+     * \retval false corrupt source or length mismatch
+     */
+    static bool Decode(const uint8_t *src, const uint32_t src_len, uint8_t *dst, const uint32_t dst_len) {
+        uint32_t i = 0, o = 0, n;
+        uint8_t c;
+
+        while(i < src_len) {
+            c = src[i++];
+            if (c < 128) {
+                n = static_cast<uint32_t>(c + 1);
+                if ((i + n) > src_len || (o + n) > dst_len) {
+                    return false;
+                }
+                while(n--) {
+                    dst[o++] = src[i++];
+                }
+            }else {
+                n = static_cast<uint32_t>(c - 125);
+                if (i >= src_len || (o + n) > dst_len) {
+                    return false;
+                }
+                while(n--) {
+                    dst[o++] = src[i];
+                }
+                i++;
+            }
+        }
+
+        return o == dst_len;
+    } // Decode(...)
+}; // class Rle
+
+
+/**
+ * A class offering persistent storage access to a user supplied structure stored compressed.  Each
+ * stored copy is a record of header and compressed ADT starting on a page boundary, its size taken
+ * from the compressed length held in header field bytes.  Large ADT with long runs of repeated values
+ * so use fewer pages per copy, fewer pages are erased per save and more copies fit the same media.
+ * Compression takes place between this class and the media, on \ref Save and \ref Load.
+ *
+ * Records follow each other through the storage pages used as a ring, a record that won't fit before
+ * the end starts again at the first page.  ADT that doesn't compress smaller is stored raw (header
+ * bytes flag \ref RAW), a save never fails because of the data.
+ *
+ * \code
+ * // 2KB table, records of 1 page rather than 3 while it compresses below 1KB
+ * persist::Compressed<table_t> g_table_ps(g_media, start, end);
+ * \endcode
+ *
+ * \note Media copy of the compressed form is held in RAM, sizeof(T) plus header
+ * \note A cold \ref Load reads the header at the start of every page, as records may start on any
+ *
+ * \tparam T ADT type name
+ * \tparam CODEC compression codec class offering static Encode/Decode, default \ref Rle
+ */
+template<typename T, typename CODEC = Rle>
+class Compressed {
+public:
+    /**
+     * Header bytes flag, ADT stored without compression
+     */
+    static const uint32_t RAW = 0x80000000UL;
+
+#pragma pack(push, 4) // Optimised for ARM
+    /**
+     * Record raw storage format written to media, only header and the stored length are written
+     */
+    struct tRecord {
+        HeadStd::tHead meta;               // bytes is stored length, RAW flag
+        union {
+            uint8_t  z[sizeof(T)];
+            uint32_t u32[(sizeof(T) / sizeof(uint32_t)) + ((sizeof(T) % sizeof(uint32_t)) ? 1 : 0)];
+        };
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(tRecord) / sizeof(uint32_t) <= 0x7fff, "ADT too large for media access");
+
+
+    /**
+     * Constructor based upon required ware level. You will have to load your ADT via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start location or offset into media for first write.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] ware_level ware levels N (minimum) of ADT stored raw, more while it compresses
+     */
+    Compressed(Media &m, uint32_t *start, uint8_t ware_level) : media_(m), start_(start) {
+        page_u32_ = media_.GetPageSize()>>2;
+        pages_ = GetRecordPages(sizeof(T)) * ware_level;
+        Unload();
+    } // Compressed(...)
+
+
+    /**
+     * Constructor based upon start and end pointers covering range for storage. You will have to
+     * load your ADT via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start location or offset into media for first write.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] end location or offset into media for first write.  Numeric may not represent
+     * a valid CPU address.  Should be > start.
+     */
+    Compressed(Media &m, uint32_t *start, uint32_t *end) : media_(m), start_(start) {
+        page_u32_ = media_.GetPageSize()>>2;
+        pages_ = static_cast<uint32_t>((end - start) * sizeof(uint32_t)) / media_.GetPageSize();
+        Unload();
+    } // Compressed(...)
+
+
+    /**
+     * Unload internal record.  Clears data and loaded state
+     */
+    void Unload() {
+        HeadStd::Clear(rec_.meta);
+        current_.loaded = false;
+        current_.location = 0;
+        current_.pages = 0;
+        current_.counter = 0;
+    } // Unload()
+
+
+    /**
+     * Load and decompress ADT from media.  When already loaded only the header on media is read and
+     * compared, the record is read again only when it differs.
+     *
+     * \param[out] data block ADT
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool Load(T &data) {
+        return Locate() && Decode(data);
+    } // Load(...)
+
+
+    /**
+     * Compress and save ADT to media.  The record is written following the current one, on write
+     * failure at the following pages.  The current record is never overwritten.
+     *
+     * \param[in] data block ADT
+     * \param[in] not_loaded_force default false.  Required if not loaded to force save of given ADT to media
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Save(T &data, bool not_loaded_force=false) {
+        uint32_t *l, n, i;
+        bool done = false;
+
+        if (WillFit() && (current_.loaded || not_loaded_force)) {
+            l = current_.loaded ? current_.location + current_.pages * page_u32_ : start_;
+            Encode(data, current_.loaded ? current_.counter + 1 : 0);
+            n = GetRecordPages(GetBytes());
+
+            // Write attempt loop, each page in turn
+            for(i = 0; !done && i < pages_; i++) {
+                if (l + n * page_u32_ > start_ + pages_ * page_u32_) {
+                    l = start_;
+                }
+                if (IsFree(l, n) && media_.Program(l, reinterpret_cast<uint32_t*>(&rec_.meta),
+                                                    static_cast<int16_t>(GetRecordU32(GetBytes())), page_u32_, true)) {
+                    done = true;
+                    current_.loaded = true;
+                    current_.location = l;
+                    current_.pages = n;
+                    current_.counter = HeadStd::GetCounter(rec_.meta);
+                }else {
+                    l+= page_u32_;
+                }
+            }
+        }
+
+        return done;
+    } // Save(...)
+
+
+    /**
+     * Query internal record been loaded from media
+     *
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool IsLoaded() const {
+        return current_.loaded;
+    } // IsLoaded()
+
+
+    /**
+     * Query, is ADT of loaded or last saved record stored raw (didn't compress)
+     *
+     * \retval true raw
+     * \retval false compressed
+     */
+    bool IsRaw() const {
+        return (rec_.meta.bytes & RAW) != 0;
+    } // IsRaw()
+
+
+    /**
+     * Get stored length of loaded or last saved record, excluding header
+     *
+     * \return Length, Bytes
+     */
+    uint32_t GetBytes() const {
+        return rec_.meta.bytes & ~RAW;
+    } // GetBytes()
+
+
+    /**
+     * Get location on media of currently loaded or last written record
+     *
+     * \note Use as debugging aid
+     *
+     * \return Pointer.  Numeric may not represent a valid CPU address.
+     */
+    uint32_t* GetLocation() const {
+        return current_.location;
+    } // GetLocation()
+
+
+    /**
+     * Get ware levelling counter of currently loaded record
+     *
+     * \return N
+     */
+    uint32_t GetCounter() const {
+        return current_.counter;
+    } // GetCounter()
+
+
+    /**
+     * Get raw storage media page count allocated for records
+     *
+     * \note Use as debugging aid
+     *
+     * \return N pages
+     */
+    uint32_t GetPages() const {
+        return pages_;
+    } // GetPages()
+
+
+    /**
+     * Get largest record storage size, ADT stored raw
+     *
+     * \return Size, Bytes
+     */
+    static constexpr uint32_t GetStorageUnitSize() {
+        return sizeof(tRecord);
+    } // GetStorageUnitSize()
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Get number of pages covered by a record
+     *
+     * \param[in] bytes stored length, excluding header
+     * \return N pages
+     */
+    uint32_t GetRecordPages(const uint32_t bytes) const {
+        return (sizeof(HeadStd::tHead) + bytes + media_.GetPageSize() - 1) / media_.GetPageSize();
+    } // GetRecordPages(...)
+
+
+    /**
+     * Get size of a record rounded to words
+     *
+     * \param[in] bytes stored length, excluding header
+     * \return Size, sizeof(uint32_t) multiples
+     */
+    static uint32_t GetRecordU32(const uint32_t bytes) {
+        return (sizeof(HeadStd::tHead) + bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    } // GetRecordU32(...)
+
+
+    /**
+     * Query, will a raw record fit on storage media
+     *
+     * \retval true fits
+     * \retval false won't fit
+     */
+    bool WillFit() const {
+        return page_u32_ && GetRecordPages(sizeof(T)) <= pages_;
+    } // WillFit()
+
+
+    /**
+     * Query, may record of n pages be written at location, within storage and not over current record
+     *
+     * \param[in] l location
+     * \param[in] n pages
+     * \retval true free
+     * \retval false not free
+     */
+    bool IsFree(uint32_t *l, const uint32_t n) const {
+        return l + n * page_u32_ <= start_ + pages_ * page_u32_ && (!current_.loaded || \
+                l >= current_.location + current_.pages * page_u32_ || l + n * page_u32_ <= current_.location);
+    } // IsFree(...)
+
+
+    /**
+     * Query, is header plausible at location without checking data.  Stored length must be within ADT
+     * size and record within storage
+     *
+     * \param[in] h header
+     * \param[in] l location
+     * \retval true plausible
+     * \retval false not a header (erased, data of another record)
+     */
+    bool IsSane(const HeadStd::tHead &h, uint32_t *l) const {
+        uint32_t b = h.bytes & ~RAW;
+
+        return b && b <= sizeof(T) && (!(h.bytes & RAW) || b == sizeof(T)) && \
+                l + GetRecordPages(b) * page_u32_ <= start_ + pages_ * page_u32_;
+    } // IsSane(...)
+
+
+    /**
+     * Read record at location into internal record, header is checked then data CRC
+     *
+     * \param[in] l location
+     * \retval true read and valid
+     * \retval false read failure, not a header or CRC mismatch
+     */
+    bool Read(uint32_t *l) {
+        uint32_t n;
+        bool ok = media_.Read(l, reinterpret_cast<uint32_t*>(&rec_.meta), sizeof(HeadStd::tHead) / sizeof(uint32_t)) && IsSane(rec_.meta, l);
+
+        if (ok) {
+            n = GetRecordU32(GetBytes()) - sizeof(HeadStd::tHead) / sizeof(uint32_t);
+            ok = media_.Read(l + sizeof(HeadStd::tHead) / sizeof(uint32_t), rec_.u32, static_cast<int16_t>(n)) && \
+                    HeadStd::IsSealed(rec_.meta, media_.Crc(rec_.u32, static_cast<uint16_t>(n)), rec_.meta.bytes);
+        }
+        if (ok) {
+            current_.loaded = true;
+            current_.location = l;
+            current_.pages = GetRecordPages(GetBytes());
+            current_.counter = HeadStd::GetCounter(rec_.meta);
+        }else {
+            HeadStd::Invalidate(rec_.meta);
+        }
+
+        return ok;
+    } // Read(...)
+
+
+    /**
+     * Locate most recent valid record on media and read it into internal record.  When already loaded,
+     * the header at the current location is compared and the record re-read only when different.
+     * Otherwise every page start is checked for a header, the newest is read and on CRC mismatch
+     * progressively older ones.
+     *
+     * \retval true located and loaded
+     * \retval false not found
+     */
+    bool Locate() {
+        HeadStd::tHead h;
+        uint32_t *l, *b = NULL, *lb = NULL, c = 0, lc = 0, i, j;
+        bool ok = false;
+
+        if (WillFit()) {
+            if (current_.loaded) {
+                ok = media_.Read(current_.location, reinterpret_cast<uint32_t*>(&h), sizeof(h) / sizeof(uint32_t)) && \
+                        h.crc == rec_.meta.crc && h.counter == rec_.meta.counter && h.bytes == rec_.meta.bytes;
+                current_.loaded = ok || Read(current_.location);
+                ok = current_.loaded;
+            }
+
+            // Newest header older than the last tried, (counter, location) order
+            for(j = 0; !ok && j < pages_; j++) {
+                for(i = 0, l = start_, b = NULL; i < pages_; i++, l+= page_u32_) {
+                    if (media_.Read(l, reinterpret_cast<uint32_t*>(&h), sizeof(h) / sizeof(uint32_t)) && IsSane(h, l) && \
+                            (!lb || h.counter < lc || (h.counter == lc && l < lb)) && \
+                            (!b || h.counter > c || (h.counter == c && l > b))) {
+                        b = l;
+                        c = h.counter;
+                    }
+                }
+                if (!b) {
+                    break;
+                }
+                ok = Read(b);
+                lb = b;
+                lc = c;
+            }
+        }
+
+        return ok;
+    } // Locate()
+
+
+    /**
+     * Compress ADT into internal record and seal it.  Stored raw when it doesn't compress smaller
+     *
+     * \param[in] data block ADT
+     * \param[in] counter write counter
+     */
+    void Encode(const T &data, const uint32_t counter) {
+        uint32_t b, i;
+
+        for(i = 0; i < sizeof(rec_.u32) / sizeof(uint32_t); i++) {
+            rec_.u32[i] = 0xffffffffUL;
+        }
+        b = CODEC::Encode(reinterpret_cast<const uint8_t*>(&data), sizeof(T), rec_.z, sizeof(T) - 1);
+        if (!b) {
+            for(i = 0; i < sizeof(T); i++) {
+                rec_.z[i] = reinterpret_cast<const uint8_t*>(&data)[i];
+            }
+            b = sizeof(T) | RAW;
+        }
+        HeadStd::SetCounter(rec_.meta, counter);
+        HeadStd::Seal(rec_.meta, media_.Crc(rec_.u32, static_cast<uint16_t>(GetRecordU32(b & ~RAW) - \
+                        sizeof(HeadStd::tHead) / sizeof(uint32_t))), b);
+    } // Encode(...)
+
+
+    /**
+     * Decompress internal record into ADT
+     *
+     * \param[out] data block ADT
+     * \retval true success
+     * \retval false corrupt
+     */
+    bool Decode(T &data) const {
+        bool ok = true;
+
+        if (IsRaw()) {
+            for(uint32_t i = 0; i < sizeof(T); i++) {
+                reinterpret_cast<uint8_t*>(&data)[i] = rec_.z[i];
+            }
+        }else {
+            ok = CODEC::Decode(rec_.z, GetBytes(), reinterpret_cast<uint8_t*>(&data), sizeof(T));
+        }
+
+        return ok;
+    } // Decode(...)
+
+
+protected:
+    struct {
+        bool        loaded;
+        uint32_t*   location;
+        uint32_t    pages;          // Record pages
+        uint32_t    counter;
+    }current_;
+    Media&          media_;
+    uint32_t*       start_;
+    uint32_t        page_u32_;
+    uint32_t        pages_;
+    tRecord         rec_;
+/*! \endcond */
+}; // class Compressed
+
+} // namespace persist
+
+#endif // PERSISTCOMPRESS_H
@@ -0,0 +1,254 @@
+/**
+ * \file
+ * Persistent high endurance monotonic counter
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTCOUNTER_H
+#define PERSISTCOUNTER_H
+
+#include "media.h"
+
+
+namespace persist {
+
+/**
+ * A class offering a persistent monotonic counter (boot count, operating hours).  Each increment
+ * spends one word, or one bit, of an erased page by clearing it via \ref Media::Write so a page erase
+ * is only required once a page is exhausted.  Two pages are used alternately, each starts with
+ * a base value header:
+ *
+ * \code
+ * [base][~base] [unit] [unit] ... [unit]
+ * \endcode
+ *
+ * Counter value is base of the page with the largest valid base plus count of used units in it.  When
+ * a page is exhausted the other page is erased and started with base of the current value, the
+ * exhausted page is kept until the next switch so power loss at any point loses no count.
+ *
+ * \code
+ * persist::Counter g_boots(g_media, start);
+ *
+ * g_boots.Increment();
+ * uint32_t n = g_boots.Get();
+ * \endcode
+ *
+ * On a 1KB page word mode gives 254 increments per erase and bit mode 8128.
+ *
+ * \attention Bit mode writes each word up to 32 times.  Use only where media allows a written word to
+ * be written again clearing further bits (AVR flash and EEPROM).  STM32F1 flash allows a written half
+ * word to be written again only with zero so use word mode.
+ */
+class Counter {
+public:
+    /**
+     * Constructor. You will have to load via \ref Load or first \ref Increment
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media, 2 pages are used.  Numeric may not
+     * represent a valid CPU address.
+     * \param[in] bits default false.  Spend one bit per increment rather than one word
+     */
+    Counter(Media &m, uint32_t *start, const bool bits=false) : media_(m), start_(start), bits_(bits) {
+        page_u32_ = media_.GetPageSize()>>2;
+        base_ = count_ = 0;
+        active_ = 0;
+        valid_ = loaded_ = false;
+    } // Counter(...)
+
+
+    /**
+     * Load counter from media.  Both page headers are read and the used units of the active page
+     * found by binary search, so cost is independent of counter value
+     *
+     * \retval true loaded, counter may be zero
+     * \retval false media pages too small
+     */
+    bool Load() {
+        uint32_t h[HEAD_U32];
+        uint8_t p;
+
+        valid_ = false;
+        base_ = count_ = 0;
+        loaded_ = page_u32_ > HEAD_U32;
+        if (loaded_) {
+            for(p = 0; p < 2; p++) {
+                if (media_.Read(GetPageLocation(p), h, HEAD_U32) && h[1] == ~h[0] && h[0] != media_.GetEraseState()) {
+                    if (!valid_ || h[0] > base_) {
+                        base_ = h[0];
+                        active_ = p;
+                        valid_ = true;
+                    }
+                }
+            }
+
+            if (valid_) {
+                count_ = FindUnits();
+            }
+        }
+
+        return loaded_;
+    } // Load()
+
+
+    /**
+     * Increment counter.  Writes a single word, the other page is erased when the active page is exhausted
+     *
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Increment() {
+        uint32_t *l, w;
+        bool done = false;
+
+        if (loaded_ || Load()) {
+            done = true;
+            if (!valid_ || count_ >= GetUnitsPerPage()) {
+                done = OpenPage();
+            }
+
+            if (done) {
+                if (bits_) {
+                    // Clear bits up to and including next unused bit
+                    l = GetPageLocation(active_) + HEAD_U32 + (count_ >> 5);
+                    w = ((count_ & 31) == 31) ? 0 : (0xffffffffUL << ((count_ & 31) + 1));
+                }else {
+                    l = GetPageLocation(active_) + HEAD_U32 + count_;
+                    w = 0;
+                }
+                done = media_.Write(l, &w, 1);
+                if (done) {
+                    count_++;
+                }
+            }
+        }
+
+        return done;
+    } // Increment()
+
+
+    /**
+     * Get counter value
+     *
+     * \return N, 0 when not loaded or never incremented
+     */
+    uint32_t Get() const {
+        return base_ + count_;
+    } // Get()
+
+
+    /**
+     * Get count of increments available per page erase
+     *
+     * \return N
+     */
+    uint32_t GetUnitsPerPage() const {
+        return (page_u32_ - HEAD_U32) * (bits_ ? 32 : 1);
+    } // GetUnitsPerPage()
+
+
+    /**
+     * Query counter been loaded from media
+     *
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool IsLoaded() const {
+        return loaded_;
+    } // IsLoaded()
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Page header size, sizeof(uint32_t) multiples
+     */
+    enum {
+        HEAD_U32 = 2
+    };
+
+
+    /**
+     * Find used units of active page.  Units are used in order so binary search for first word not
+     * fully used and, in bit mode, count its cleared bits
+     *
+     * \return N
+     */
+    uint32_t FindUnits() {
+        uint32_t *l = GetPageLocation(active_) + HEAD_U32;
+        uint32_t lo = 0, hi = page_u32_ - HEAD_U32, mid, w = 0;
+
+        while(lo < hi) {
+            mid = (lo + hi) >> 1;
+            if (media_.Read(l + mid, &w, 1) && (bits_ ? (w != 0) : (w == media_.GetEraseState()))) {
+                hi = mid;
+            }else {
+                lo = mid + 1;
+            }
+        }
+
+        if (bits_) {
+            // Count cleared bits of partly used word
+            w = media_.GetEraseState();
+            if (lo < page_u32_ - HEAD_U32) {
+                media_.Read(l + lo, &w, 1);
+            }
+            mid = 32;
+            for(; w; w&= w - 1) {
+                mid--;
+            }
+            lo = (lo << 5) + mid;
+        }
+
+        return lo;
+    } // FindUnits()
+
+
+    /**
+     * Open other page with base of current value.  Page is erased and header written, active page
+     * remains valid until then
+     *
+     * \retval true opened
+     * \retval false erase or write failed
+     */
+    bool OpenPage() {
+        uint8_t p = valid_ ? static_cast<uint8_t>(active_ ^ 1) : 0;
+        uint32_t *l = GetPageLocation(p);
+        uint32_t h[HEAD_U32];
+        bool done;
+
+        h[0] = Get();
+        h[1] = ~h[0];
+        done = media_.Erase(l, 1) && media_.Write(l, h, HEAD_U32);
+        if (done) {
+            base_ = h[0];
+            count_ = 0;
+            active_ = p;
+            valid_ = true;
+        }
+
+        return done;
+    } // OpenPage()
+
+
+    uint32_t* GetPageLocation(const uint8_t page) const {
+        return start_ + static_cast<uint32_t>(page) * page_u32_;
+    } // GetPageLocation(...)
+
+
+protected:
+    Media       &media_;
+    uint32_t    *start_;            // Location of first page
+    uint32_t    page_u32_;          // Media page size, sizeof(uint32_t) multiples
+    uint32_t    base_;              // Active page base value
+    uint32_t    count_;             // Active page used units
+    uint8_t     active_;            // Active page
+    bool        bits_;              // Bit mode
+    bool        valid_;             // Active page exists
+    bool        loaded_;
+/*! \endcond */
+}; // class Counter
+
+} // namespace persist
+
+#endif // PERSISTCOUNTER_H
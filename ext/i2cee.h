@@ -0,0 +1,279 @@
+/**
+ * \file
+ * Media wrapper for external I2C EEPROM (24LCxx class)
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTI2CEE_H
+#define PERSISTI2CEE_H
+
+#include "media.h"                // Persist base
+#include "sw/crc.h"
+
+
+namespace wrap {
+
+/**
+ * Wrapper for I2C EEPROM (24LC01 to 24LC512 class).  Writes are page aligned bursts of only the changed
+ * Bytes of each write page, completion is found by ACK polling rather than a fixed delay and each
+ * write page is verified with a single block read.  Media page size is the write page size (16 to 128
+ * Bytes), there is no erase.  Locations are Byte offsets into the device, numeric does not represent
+ * a valid CPU address.
+ *
+ * I2C access is a user supplied transfer function so any I2C driver, or a host emulator, can be used.
+ * Each call is one bus transaction: device addressed for write, address Bytes sent then size Bytes
+ * either sent from tx or, after a repeated start for read, received into rx.  A call without address
+ * Bytes or data is an ACK poll.
+ *
+ * \code
+ * wrap::I2cEe g_ee(EeTransfer, NULL, 0x50, 32768, 64);    // 24LC256
+ * persist::Struct<cfg_t> g_cfg_ps(g_ee, g_ee.GetStart(), 4);
+ * \endcode
+ *
+ * \note Devices of 2KB or less take 1 address Byte, higher address bits are in the device address
+ */
+class I2cEe : public persist::Media, protected swimp::Crc {
+public:
+    /**
+     * I2C transfer, one bus transaction
+     *
+     * \param[in] context user context given to constructor
+     * \param[in] device 7bit device address
+     * \param[in] address memory address Bytes, MSB first
+     * \param[in] address_size address Bytes, 0 for ACK poll
+     * \param[in] tx data to write or NULL
+     * \param[out] rx data read or NULL
+     * \param[in] size data Bytes, may be 0
+     * \retval true device acknowledged
+     * \retval false NACK (busy) or bus error
+     */
+    typedef bool (*tTransfer)(void *context, const uint8_t device, const uint8_t *address, const uint8_t address_size,
+                                const uint8_t *tx, uint8_t *rx, const uint16_t size);
+
+    /**
+     * Constructor
+     *
+     * \param[in] transfer I2C transfer function
+     * \param[in] context user context passed to transfer
+     * \param[in] device 7bit device address, usually 0x50 plus address pins
+     * \param[in] size device size (Bytes)
+     * \param[in] write_page device write page size (Bytes), 8 to 128 power of 2.  Rounded down to a power
+     * of 2 within range
+     */
+    I2cEe(tTransfer transfer, void *context, const uint8_t device, const uint32_t size, const uint16_t write_page) :
+                transfer_(transfer), context_(context), device_(device), size_(size) {
+        write_page_ = static_cast<uint16_t>(WRITE_PAGE_MIN);
+        while(write_page_ < static_cast<uint16_t>(WRITE_PAGE_MAX) && (write_page_<<1) <= write_page) {
+            write_page_<<= 1;
+        }
+        address_size_ = (size_ > 2048) ? 2 : 1;
+    } // I2cEe(...)
+
+
+    uint32_t GetPageSize() const {
+        return write_page_;
+    }
+
+    uint32_t GetSize() const {
+        return size_;
+    }
+
+    uint32_t* const GetStart() const {
+        return 0;
+    }
+
+    uint32_t* const GetEnd() const {
+        return GetStart() + (GetSize()>>2);
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        const uint8_t *d = reinterpret_cast<const uint8_t*>(data);
+        uint32_t a = GetAddress(buffer), left = static_cast<uint32_t>(size_u32)<<2;
+        uint16_t n;
+        bool done = true;
+
+        (void)page_size_u32;
+        (void)use_lock;
+
+        // Write page at a time
+        while(done && left) {
+            n = static_cast<uint16_t>(write_page_ - (a & (write_page_ - 1)));
+            if (n > left) {
+                n = static_cast<uint16_t>(left);
+            }
+
+            done = ProgramPage(a, d, n);
+            a+= n;
+            d+= n;
+            left-= n;
+        }
+
+        return done;
+    } // Program(...)
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        return ReadBytes(GetAddress(buffer), reinterpret_cast<uint8_t*>(const_cast<uint32_t*>(data)),
+                            static_cast<uint32_t>(size_u32)<<2);
+    } // Read(...)
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return swimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        // EEPROM has no erase constraint
+        return Program(buffer, data, size_u32, 0, false);
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        uint32_t e[WRITE_PAGE_MAX>>2];
+        uint32_t i;
+        bool done = true;
+
+        for(i = 0; i < (WRITE_PAGE_MAX>>2); i++) {
+            e[i] = GetEraseState();
+        }
+        for(i = 0; done && i < pages; i++) {
+            done = Program(buffer + i * (write_page_>>2), e, static_cast<int16_t>(write_page_>>2), 0, false);
+        }
+
+        return done;
+    } // Erase(...)
+
+/*! \cond PRIVATE */
+protected:
+    enum {
+        WRITE_PAGE_MIN = 8,
+        WRITE_PAGE_MAX = 128,
+
+        // ACK polls before a write is taken as failed, 5ms write cycle at 400KHz is about 50
+        POLL_LIMIT = 2000
+    };
+
+
+    static uint32_t GetAddress(const uint32_t *buffer) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(buffer));
+    } // GetAddress(...)
+
+
+    /**
+     * Set device and address Bytes of memory address.  With 1 address Byte higher bits select a
+     * 256 Byte block via device address
+     *
+     * \param[in] address Byte address
+     * \param[out] a address Bytes
+     * \return 7bit device address
+     */
+    uint8_t SetAddress(const uint32_t address, uint8_t *a) const {
+        uint8_t device = device_;
+
+        if (address_size_ == 1) {
+            device|= static_cast<uint8_t>((address >> 8) & 0x07);
+            a[0] = static_cast<uint8_t>(address);
+        }else {
+            a[0] = static_cast<uint8_t>(address >> 8);
+            a[1] = static_cast<uint8_t>(address);
+        }
+
+        return device;
+    } // SetAddress(...)
+
+
+    /**
+     * Read Bytes, split at 256 Byte blocks with 1 address Byte (32KB otherwise, fits transfer size)
+     *
+     * \param[in] address Byte address
+     * \param[out] data destination
+     * \param[in] size Bytes
+     * \retval true read
+     * \retval false bus error
+     */
+    bool ReadBytes(uint32_t address, uint8_t *data, uint32_t size) {
+        uint8_t a[2], device;
+        uint32_t n;
+        bool ok = true;
+
+        while(ok && size) {
+            n = (address_size_ == 1) ? 256 - (address & 0xff) : 0x8000UL - (address & 0x7fffUL);
+            if (n > size) {
+                n = size;
+            }
+
+            device = SetAddress(address, a);
+            ok = transfer_(context_, device, a, address_size_, NULL, data, static_cast<uint16_t>(n));
+            address+= n;
+            data+= n;
+            size-= n;
+        }
+
+        return ok;
+    } // ReadBytes(...)
+
+
+    /**
+     * Program Bytes within a write page.  Only the span of changed Bytes is written, then verified
+     * with a single block read
+     *
+     * \param[in] address Byte address
+     * \param[in] data source
+     * \param[in] size Bytes, within one write page
+     * \retval true on success (including nothing changed)
+     * \retval false write or verify failure
+     */
+    bool ProgramPage(const uint32_t address, const uint8_t *data, const uint16_t size) {
+        uint8_t b[WRITE_PAGE_MAX], a[2], device;
+        uint16_t first, last, i;
+        bool done = ReadBytes(address, b, size);
+
+        if (done) {
+            // Span of changed Bytes
+            for(first = 0; first < size && b[first] == data[first]; first++);
+            for(last = size; last > first && b[last - 1] == data[last - 1]; last--);
+
+            if (first < last) {
+                device = SetAddress(address + first, a);
+                done = transfer_(context_, device, a, address_size_, data + first, NULL, last - first) && WaitReady() && \
+                        ReadBytes(address + first, b, last - first);
+                for(i = 0; done && i < last - first; i++) {
+                    done = b[i] == data[first + i];
+                }
+            }
+        }
+
+        return done;
+    } // ProgramPage(...)
+
+
+    /**
+     * ACK poll until write cycle done
+     *
+     * \retval true device ready
+     * \retval false timeout
+     */
+    bool WaitReady() {
+        uint16_t i;
+        bool ok = false;
+
+        for(i = 0; !ok && i < POLL_LIMIT; i++) {
+            ok = transfer_(context_, device_, NULL, 0, NULL, NULL, 0);
+        }
+
+        return ok;
+    } // WaitReady()
+
+
+protected:
+    tTransfer   transfer_;
+    void        *context_;
+    uint8_t     device_;            // 7bit device address
+    uint8_t     address_size_;      // Address Bytes
+    uint16_t    write_page_;        // Write page, Bytes
+    uint32_t    size_;              // Device size, Bytes
+/*! \endcond */
+}; // class I2cEe
+
+} // namespace wrap
+
+#endif // PERSISTI2CEE_H
@@ -0,0 +1,208 @@
+/**
+ * \file
+ * Media wrapper for external SPI FRAM (MB85RS / FM25V class)
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTSPIFRAM_H
+#define PERSISTSPIFRAM_H
+
+#include "media.h"                // Persist base
+#include "sw/crc.h"
+
+
+namespace wrap {
+
+/**
+ * Wrapper for SPI FRAM.  No erase, no write delay and no practical wear so \ref NeedsErase is false
+ * and \ref persist::Struct uses two slots alternately.  Only changed Bytes are written, then read back
+ * to verify.  Media page size is nominal, choose one suiting structure size.  Locations are Byte offsets
+ * into the device, numeric does not represent a valid CPU address.
+ *
+ * SPI access is a user supplied transfer function as \ref SpiNor, one call per chip select.
+ *
+ * \code
+ * wrap::SpiFram<64> g_fram(FramTransfer, NULL, 32768);    // MB85RS256
+ * persist::Struct<cfg_t> g_cfg_ps(g_fram, g_fram.GetStart(), 2);
+ * \endcode
+ *
+ * \tparam PSZ nominal page size (Bytes), multiple of 32
+ */
+template<uint16_t PSZ>
+class SpiFram : public persist::Media, protected swimp::Crc {
+public:
+    /**
+     * SPI transfer, one chip select
+     *
+     * \param[in] context user context given to constructor
+     * \param[in] cmd command and address Bytes
+     * \param[in] cmd_size command Bytes
+     * \param[in] tx data phase to send or NULL
+     * \param[out] rx data phase receive or NULL
+     * \param[in] size data phase Bytes, may be 0
+     * \retval true transferred
+     * \retval false failed
+     */
+    typedef bool (*tTransfer)(void *context, const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx,
+                                uint8_t *rx, const uint16_t size);
+
+    /**
+     * Constructor
+     *
+     * \param[in] transfer SPI transfer function
+     * \param[in] context user context passed to transfer
+     * \param[in] size device size (Bytes).  Above 64KB 3 address Bytes are used
+     */
+    SpiFram(tTransfer transfer, void *context, const uint32_t size) : transfer_(transfer), context_(context), size_(size) {
+    } // SpiFram(...)
+
+
+    uint32_t GetPageSize() const {
+        return PSZ;
+    }
+
+    uint32_t GetSize() const {
+        return size_;
+    }
+
+    uint32_t* const GetStart() const {
+        return 0;
+    }
+
+    uint32_t* const GetEnd() const {
+        return GetStart() + (GetSize()>>2);
+    }
+
+    bool NeedsErase() const {
+        return false;
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        const uint8_t *d = reinterpret_cast<const uint8_t*>(data);
+        uint32_t a = GetAddress(buffer), left = static_cast<uint32_t>(size_u32)<<2;
+        uint8_t b[32];
+        uint16_t n, first, last, i;
+        bool done = true;
+
+        (void)page_size_u32;
+        (void)use_lock;
+
+        // Compare in chunks, write span of changed Bytes and verify (SPI has no acknowledge, a write
+        // protected or absent device takes the write silently)
+        while(done && left) {
+            n = static_cast<uint16_t>((left > sizeof(b)) ? sizeof(b) : left);
+            done = Transfer(CMD_READ, a, NULL, b, n);
+            if (done) {
+                for(first = 0; first < n && b[first] == d[first]; first++);
+                for(last = n; last > first && b[last - 1] == d[last - 1]; last--);
+                if (first < last) {
+                    done = Transfer(CMD_WRITE_ENABLE, 0, NULL, NULL, 0) && Transfer(CMD_WRITE, a + first, d + first, NULL, last - first) && \
+                            Transfer(CMD_READ, a + first, NULL, b, last - first);
+                    for(i = 0; done && i < last - first; i++) {
+                        done = b[i] == d[first + i];
+                    }
+                }
+            }
+            a+= n;
+            d+= n;
+            left-= n;
+        }
+
+        return done;
+    } // Program(...)
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint8_t *d = reinterpret_cast<uint8_t*>(const_cast<uint32_t*>(data));
+        uint32_t a = GetAddress(buffer), left = static_cast<uint32_t>(size_u32)<<2, n;
+        bool done = true;
+
+        // Split, transfer size is 16bit
+        while(done && left) {
+            n = (left > READ_SIZE) ? READ_SIZE : left;
+            done = Transfer(CMD_READ, a, NULL, d, static_cast<uint16_t>(n));
+            a+= n;
+            d+= n;
+            left-= n;
+        }
+
+        return done;
+    } // Read(...)
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return swimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        return Program(buffer, data, size_u32, 0, false);
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        uint32_t e[32>>2];          // Page size multiple, small stack on AVR
+        uint32_t i;
+        bool done = true;
+
+        for(i = 0; i < (sizeof(e)>>2); i++) {
+            e[i] = GetEraseState();
+        }
+        for(i = 0; done && i < pages * (PSZ>>2); i+= (sizeof(e)>>2)) {
+            done = Program(buffer + i, e, static_cast<int16_t>(sizeof(e)>>2), 0, false);
+        }
+
+        return done;
+    } // Erase(...)
+
+/*! \cond PRIVATE */
+protected:
+    enum {
+        CMD_WRITE_ENABLE = 0x06,
+        CMD_READ = 0x03,
+        CMD_WRITE = 0x02,
+
+        READ_SIZE = 0x8000          // Transfer size limit 0xffff
+    };
+
+
+    static uint32_t GetAddress(const uint32_t *buffer) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(buffer));
+    } // GetAddress(...)
+
+
+    /**
+     * Command with address (not write enable) and data phase
+     *
+     * \param[in] op command
+     * \param[in] address Byte address
+     * \param[in] tx data to send or NULL
+     * \param[out] rx data receive or NULL
+     * \param[in] size data Bytes
+     * \retval true transferred
+     * \retval false failed
+     */
+    bool Transfer(const uint8_t op, const uint32_t address, const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+        uint8_t cmd[4], n = 1;
+
+        cmd[0] = op;
+        if (op != CMD_WRITE_ENABLE) {
+            if (size_ > 0x10000UL) {
+                cmd[n++] = static_cast<uint8_t>(address >> 16);
+            }
+            cmd[n++] = static_cast<uint8_t>(address >> 8);
+            cmd[n++] = static_cast<uint8_t>(address);
+        }
+
+        return transfer_(context_, cmd, n, tx, rx, size);
+    } // Transfer(...)
+
+
+protected:
+    tTransfer   transfer_;
+    void        *context_;
+    uint32_t    size_;              // Device size, Bytes
+/*! \endcond */
+}; // class SpiFram
+
+} // namespace wrap
+
+#endif // PERSISTSPIFRAM_H
@@ -0,0 +1,378 @@
+/**
+ * \file
+ * Media wrapper for external SPI NOR flash (W25Qxx class)
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTSPINOR_H
+#define PERSISTSPINOR_H
+
+#include "media.h"                // Persist base
+#include "sw/crc.h"
+
+
+namespace wrap {
+
+/**
+ * Wrapper for standard SPI NOR flash (JEDEC 0x9f ID, 3 Byte address, 256 Byte page program, 4KB, 32KB
+ * and 64KB erase).  Media pages are erase sectors (default 4KB), programs are split at 256 Byte
+ * program pages (see \ref GetProgramSize).  Locations are Byte offsets into the device, numeric does
+ * not represent a valid CPU address.
+ *
+ * SPI access is a user supplied transfer function so any SPI driver, or a host emulator, can be used.
+ * Each call is one chip select: command Bytes are sent then size Bytes either sent from tx or
+ * received into rx.
+ *
+ * \code
+ * bool NorTransfer(void *context, const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx,
+ *                      uint8_t *rx, const uint16_t size) {
+ *     digitalWrite(NOR_CS, LOW);
+ *     SPI.transfer(const_cast<uint8_t*>(cmd), cmd_size);   // ...and data phase
+ *     digitalWrite(NOR_CS, HIGH);
+ *     return true;
+ * }
+ *
+ * wrap::SpiNor g_nor(NorTransfer);
+ *
+ * g_nor.Probe();
+ * persist::Struct<cfg_t> g_cfg_ps(g_nor, g_nor.GetStart(), 4);
+ * \endcode
+ *
+ * \note Device must be out of power down and without block protection
+ */
+class SpiNor : public persist::Media, protected swimp::Crc {
+public:
+    /**
+     * SPI transfer, one chip select
+     *
+     * \param[in] context user context given to constructor
+     * \param[in] cmd command and address Bytes
+     * \param[in] cmd_size command Bytes
+     * \param[in] tx data phase to send or NULL
+     * \param[out] rx data phase receive or NULL
+     * \param[in] size data phase Bytes, may be 0
+     * \retval true transferred
+     * \retval false failed
+     */
+    typedef bool (*tTransfer)(void *context, const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx,
+                                uint8_t *rx, const uint16_t size);
+
+    /**
+     * Erase block sizes
+     */
+    enum {
+        ERASE_4K = 0x1000UL,
+        ERASE_32K = 0x8000UL,
+        ERASE_64K = 0x10000UL
+    };
+
+    /**
+     * Constructor
+     *
+     * \param[in] transfer SPI transfer function
+     * \param[in] context default NULL.  Passed to transfer
+     * \param[in] size default 0.  Device size (Bytes), 0 to take from \ref Probe
+     * \param[in] erase_size default 4096.  Media page size (Bytes), 4KB, 32KB or 64KB
+     */
+    SpiNor(tTransfer transfer, void *context=NULL, const uint32_t size=0, const uint32_t erase_size=ERASE_4K) :
+                transfer_(transfer), context_(context), size_(size), erase_size_(erase_size), id_(0) {
+    } // SpiNor(...)
+
+
+    /**
+     * Read JEDEC ID.  When no size given to constructor, size is taken from capacity code
+     *
+     * \retval true device responded
+     * \retval false no device (ID all 0 or 1)
+     */
+    bool Probe() {
+        uint8_t cmd = CMD_JEDEC_ID;
+        uint8_t id[3];
+        bool ok = transfer_(context_, &cmd, 1, NULL, id, sizeof(id));
+
+        if (ok) {
+            id_ = (static_cast<uint32_t>(id[0]) << 16) | (static_cast<uint32_t>(id[1]) << 8) | id[2];
+            ok = id_ && id_ != 0xffffffUL;
+        }
+        if (ok && !size_ && id[2] >= 16 && id[2] <= 24) {
+            // Capacity code is log2(Bytes), 3 Byte address maximum 16MB
+            size_ = 1UL << id[2];
+        }
+
+        return ok;
+    } // Probe()
+
+
+    /**
+     * Get JEDEC ID read by \ref Probe
+     *
+     * \return Manufacturer (bits 23:16), memory type and capacity code
+     */
+    uint32_t GetId() const {
+        return id_;
+    } // GetId()
+
+
+    uint32_t GetPageSize() const {
+        return erase_size_;
+    }
+
+    uint32_t GetProgramSize() const {
+        return PROGRAM_SIZE;
+    }
+
+    uint32_t GetSize() const {
+        return size_;
+    }
+
+    uint32_t* const GetStart() const {
+        return 0;
+    }
+
+    uint32_t* const GetEnd() const {
+        return GetStart() + (GetSize()>>2);
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        uint32_t a = GetAddress(buffer), e = a + (static_cast<uint32_t>(size_u32)<<2);
+        bool done;
+
+        (void)page_size_u32;
+        (void)use_lock;
+
+        // Already written?
+        done = Verify(a, data, size_u32);
+        if (!done) {
+            // Erase covered sectors not in erase state, write and verify
+            done = true;
+            for(a&= ~(erase_size_ - 1); done && a < e; a+= erase_size_) {
+                if (!IsErased(a)) {
+                    done = EraseBlocks(a, erase_size_);
+                }
+            }
+            done = done && Write(buffer, data, size_u32) && Verify(GetAddress(buffer), data, size_u32);
+        }
+
+        return done;
+    } // Program(...)
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint8_t *d = reinterpret_cast<uint8_t*>(const_cast<uint32_t*>(data));
+        uint32_t a = GetAddress(buffer), left = static_cast<uint32_t>(size_u32)<<2, n;
+        uint8_t cmd[4];
+        bool done = true;
+
+        // Split, transfer size is 16bit
+        while(done && left) {
+            n = (left > READ_SIZE) ? READ_SIZE : left;
+
+            SetCommand(cmd, CMD_READ, a);
+            done = transfer_(context_, cmd, sizeof(cmd), NULL, d, static_cast<uint16_t>(n));
+            a+= n;
+            d+= n;
+            left-= n;
+        }
+
+        return done;
+    } // Read(...)
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return swimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        const uint8_t *d = reinterpret_cast<const uint8_t*>(data);
+        uint32_t a = GetAddress(buffer), left = static_cast<uint32_t>(size_u32)<<2, n;
+        uint8_t cmd[4];
+        bool done = true;
+
+        // Split at program page boundaries, a program wraps within its page
+        while(done && left) {
+            n = PROGRAM_SIZE - (a & (PROGRAM_SIZE - 1));
+            if (n > left) {
+                n = left;
+            }
+
+            SetCommand(cmd, CMD_PAGE_PROGRAM, a);
+            done = WriteEnable() && transfer_(context_, cmd, sizeof(cmd), d, NULL, static_cast<uint16_t>(n)) && \
+                    WaitReady();
+            a+= n;
+            d+= n;
+            left-= n;
+        }
+
+        return done;
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        return EraseBlocks(GetAddress(buffer), pages * erase_size_);
+    } // Erase(...)
+
+/*! \cond PRIVATE */
+protected:
+    enum {
+        CMD_WRITE_ENABLE = 0x06,
+        CMD_READ_STATUS = 0x05,
+        CMD_READ = 0x03,
+        CMD_PAGE_PROGRAM = 0x02,
+        CMD_ERASE_4K = 0x20,
+        CMD_ERASE_32K = 0x52,
+        CMD_ERASE_64K = 0xd8,
+        CMD_JEDEC_ID = 0x9f,
+
+        STATUS_BUSY = 0x01,
+
+        PROGRAM_SIZE = 256,
+        READ_SIZE = 0x8000          // Transfer size limit 0xffff
+    };
+
+
+    /**
+     * Status polls before a program or erase is taken as failed.  64KB erase is up to 2s
+     */
+    enum {
+        POLL_LIMIT = 0x1000000UL
+    };
+
+
+    static uint32_t GetAddress(const uint32_t *buffer) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(buffer));
+    } // GetAddress(...)
+
+
+    static uint32_t* GetLocation(const uint32_t address) {
+        return reinterpret_cast<uint32_t*>(static_cast<uintptr_t>(address));
+    } // GetLocation(...)
+
+
+    static void SetCommand(uint8_t *cmd, const uint8_t op, const uint32_t address) {
+        cmd[0] = op;
+        cmd[1] = static_cast<uint8_t>(address >> 16);
+        cmd[2] = static_cast<uint8_t>(address >> 8);
+        cmd[3] = static_cast<uint8_t>(address);
+    } // SetCommand(...)
+
+
+    bool WriteEnable() {
+        uint8_t cmd = CMD_WRITE_ENABLE;
+
+        return transfer_(context_, &cmd, 1, NULL, NULL, 0);
+    } // WriteEnable()
+
+
+    /**
+     * Poll status register until program or erase done
+     *
+     * \retval true done
+     * \retval false transfer failed or timeout
+     */
+    bool WaitReady() {
+        uint8_t cmd = CMD_READ_STATUS, s = STATUS_BUSY;
+        uint32_t i;
+        bool ok = true;
+
+        for(i = 0; ok && (s & STATUS_BUSY) && i < POLL_LIMIT; i++) {
+            ok = transfer_(context_, &cmd, 1, NULL, &s, 1);
+        }
+
+        return ok && !(s & STATUS_BUSY);
+    } // WaitReady()
+
+
+    /**
+     * Erase range, largest aligned block erase that fits is selected each step
+     *
+     * \param[in] address erase block aligned Byte address
+     * \param[in] bytes N, erase block multiples
+     * \retval true on success
+     * \retval false failed
+     */
+    bool EraseBlocks(uint32_t address, uint32_t bytes) {
+        uint8_t cmd[4];
+        uint32_t n;
+        bool done = !(address & (ERASE_4K - 1)) && !(bytes & (ERASE_4K - 1));
+
+        while(done && bytes) {
+            if (!(address & (ERASE_64K - 1)) && bytes >= ERASE_64K) {
+                n = ERASE_64K;
+                SetCommand(cmd, CMD_ERASE_64K, address);
+            }else if (!(address & (ERASE_32K - 1)) && bytes >= ERASE_32K) {
+                n = ERASE_32K;
+                SetCommand(cmd, CMD_ERASE_32K, address);
+            }else {
+                n = ERASE_4K;
+                SetCommand(cmd, CMD_ERASE_4K, address);
+            }
+
+            done = WriteEnable() && transfer_(context_, cmd, sizeof(cmd), NULL, NULL, 0) && WaitReady();
+            address+= n;
+            bytes-= n;
+        }
+
+        return done;
+    } // EraseBlocks(...)
+
+
+    /**
+     * Query, media at Byte address matches data
+     *
+     * \param[in] address Byte address
+     * \param[in] data pointer to data
+     * \param[in] size_u32 size of data, sizeof(uint32_t) multiples
+     * \retval true same
+     * \retval false different or read failure
+     */
+    bool Verify(uint32_t address, const uint32_t *data, const int16_t size_u32) {
+        uint32_t buffer[8];
+        int16_t i, j, n;
+        bool ok = true;
+
+        for(i = 0; ok && i < size_u32; i+= n, address+= n<<2) {
+            n = (size_u32 - i > 8) ? 8 : static_cast<int16_t>(size_u32 - i);
+            ok = Read(GetLocation(address), buffer, n);
+            for(j = 0; ok && j < n; j++) {
+                ok = buffer[j] == data[i + j];
+            }
+        }
+
+        return ok;
+    } // Verify(...)
+
+
+    /**
+     * Query, erase sector at Byte address in erase state
+     *
+     * \param[in] address sector aligned Byte address
+     * \retval true erased
+     * \retval false written or read failure
+     */
+    bool IsErased(uint32_t address) {
+        uint32_t buffer[8];
+        uint32_t e = address + erase_size_, j;
+        bool ok = true;
+
+        for(; ok && address < e; address+= sizeof(buffer)) {
+            ok = Read(GetLocation(address), buffer, sizeof(buffer) / sizeof(uint32_t));
+            for(j = 0; ok && j < sizeof(buffer) / sizeof(uint32_t); j++) {
+                ok = buffer[j] == GetEraseState();
+            }
+        }
+
+        return ok;
+    } // IsErased(...)
+
+
+protected:
+    tTransfer   transfer_;
+    void        *context_;
+    uint32_t    size_;              // Device size, Bytes
+    uint32_t    erase_size_;        // Media page, Bytes
+    uint32_t    id_;                // JEDEC ID
+/*! \endcond */
+}; // class SpiNor
+
+} // namespace wrap
+
+#endif // PERSISTSPINOR_H
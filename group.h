@@ -0,0 +1,270 @@
+/**
+ * \file
+ * Atomic commit of several persistent structures
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTGROUP_H
+#define PERSISTGROUP_H
+
+#include "struct.h"
+
+
+namespace persist {
+
+/**
+ * A class offering atomic update of several \ref Struct instances that must change together (network
+ * configuration and its credentials).  Members are saved (staged) as normal and a small commit record
+ * naming the write counter of each member is saved last.  Members are loaded through the group at the
+ * committed counters, so either all new copies are seen or none are.
+ *
+ * \code
+ * persist::Group<2> g_grp(g_media, commit_start, 4);
+ *
+ * g_grp.Load();
+ * g_grp.Load(0, g_net_ps, net);
+ * g_grp.Load(1, g_cred_ps, cred);
+ *
+ * g_grp.Stage(0, g_net_ps, net);
+ * g_grp.Stage(1, g_cred_ps, cred);
+ * g_grp.Commit();
+ * \endcode
+ *
+ * Cost of a commit is N+1 saves, each member save plus one save of the N counters.  On flash each
+ * save is a page erase and write, so atomicity costs one save more than saving the members alone and
+ * no duplicate copies of member data.
+ *
+ * \note Members need at least 2 ware levels, the committed copy is kept while the staged copy is written
+ * \note After a failed \ref Commit members hold staged copies, load them again through the group
+ *
+ * \tparam N member count, maximum 32
+ */
+template<uint8_t N>
+class Group {
+public:
+    /**
+     * Commit record, write counter of each member
+     */
+    struct tCommit {
+        uint32_t counter[N];
+    };
+
+    /**
+     * Constructor based upon required ware level of commit record. You will have to load via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start location or offset into media for commit record.  Numeric may not represent
+     * a valid CPU address.  Must not overlap member storage.
+     * \param[in] ware_level ware levels N (maximum)
+     */
+    Group(Media &m, uint32_t *start, uint8_t ware_level) : ps_(m, start, ware_level) {
+        Clear();
+    } // Group(...)
+
+
+    /**
+     * Constructor based upon start and end pointers covering range for commit record storage. You will
+     * have to load via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start location or offset into media for commit record.  Numeric may not represent
+     * a valid CPU address.  Must not overlap member storage.
+     * \param[in] end location or offset into media.  Numeric may not represent a valid CPU address.
+     * Should be > start.
+     */
+    Group(Media &m, uint32_t *start, uint32_t *end) : ps_(m, start, end) {
+        Clear();
+    } // Group(...)
+
+
+    /**
+     * Load commit record from media.  Load members afterwards via \ref Load(const uint8_t, Struct&, T&)
+     *
+     * \retval true loaded
+     * \retval false never committed
+     */
+    bool Load() {
+        bool ok;
+
+        Clear();
+#if defined(PERSISTSTRUCT_POINTERS)
+        ok = ps_.Load();
+        if (ok) {
+            committed_ = *ps_.Get();
+        }
+#else // !PERSISTSTRUCT_POINTERS
+        ok = ps_.Load(committed_);
+#endif // !PERSISTSTRUCT_POINTERS
+        staged_ = committed_;
+
+        return ok;
+    } // Load()
+
+
+#if defined(PERSISTSTRUCT_POINTERS)
+    /**
+     * Load member at committed write counter
+     *
+     * \tparam T member ADT type name
+     * \tparam H member data block header policy
+     * \param[in] i member index, &lt; N
+     * \param[in,out] s member persistent structure
+     * \retval true loaded
+     * \retval false not committed or committed copy not found
+     */
+    template<typename T, typename H>
+    bool Load(const uint8_t i, Struct<T, H> &s) {
+        return i < N && ps_.IsLoaded() && s.Load(committed_.counter[i]);
+    } // Load(...)
+
+
+    /**
+     * Stage member.  Member internal data block is saved as normal but not seen by \ref Load until
+     * \ref Commit.  Stage each member at most once per commit
+     *
+     * \tparam T member ADT type name
+     * \tparam H member data block header policy
+     * \param[in] i member index, &lt; N
+     * \param[in,out] s member persistent structure, loaded through group unless never committed
+     * \retval true saved
+     * \retval false failed, already staged or member not loaded
+     */
+    template<typename T, typename H>
+    bool Stage(const uint8_t i, Struct<T, H> &s) {
+        bool ok = IsStageable(i, s.IsLoaded()) && s.Save(!s.IsLoaded());
+#else // !PERSISTSTRUCT_POINTERS
+    /**
+     * Load member at committed write counter
+     *
+     * \tparam T member ADT type name
+     * \tparam H member data block header policy
+     * \param[in] i member index, &lt; N
+     * \param[in,out] s member persistent structure
+     * \param[out] data member ADT
+     * \retval true loaded
+     * \retval false not committed or committed copy not found
+     */
+    template<typename T, typename H>
+    bool Load(const uint8_t i, Struct<T, H> &s, T &data) {
+        return i < N && ps_.IsLoaded() && s.Load(data, committed_.counter[i]);
+    } // Load(...)
+
+
+    /**
+     * Stage member.  Member data block is saved as normal but not seen by \ref Load until
+     * \ref Commit.  Stage each member at most once per commit
+     *
+     * \tparam T member ADT type name
+     * \tparam H member data block header policy
+     * \param[in] i member index, &lt; N
+     * \param[in,out] s member persistent structure, loaded through group unless never committed
+     * \param[in] data member ADT
+     * \retval true saved
+     * \retval false failed, already staged or member not loaded
+     */
+    template<typename T, typename H>
+    bool Stage(const uint8_t i, Struct<T, H> &s, T &data) {
+        bool ok = IsStageable(i, s.IsLoaded()) && s.Save(data, !s.IsLoaded());
+#endif // !PERSISTSTRUCT_POINTERS
+
+        if (ok) {
+            staged_.counter[i] = s.GetCounter();
+            staged_mask_ |= 1UL << i;
+        }
+
+        return ok;
+    } // Stage(...)
+
+
+    /**
+     * Commit staged members.  A single save of the commit record, the member saves were made by \ref Stage
+     *
+     * \retval true on success (including nothing staged)
+     * \retval false failed, previous commit remains
+     */
+    bool Commit() {
+        bool done = true;
+
+        if (staged_mask_) {
+#if defined(PERSISTSTRUCT_POINTERS)
+            *ps_.Get() = staged_;
+            done = ps_.Save(!ps_.IsLoaded());
+            if (!done) {
+                // Internal copy now invalid, recover current
+                ps_.Load();
+            }
+#else // !PERSISTSTRUCT_POINTERS
+            done = ps_.Save(staged_, !ps_.IsLoaded());
+#endif // !PERSISTSTRUCT_POINTERS
+            if (done) {
+                committed_ = staged_;
+                staged_mask_ = 0;
+            }
+        }
+
+        return done;
+    } // Commit()
+
+
+    /**
+     * Get committed write counter of member
+     *
+     * \note Use as debugging aid
+     *
+     * \param[in] i member index, &lt; N
+     * \return Counter
+     */
+    uint32_t GetCounter(const uint8_t i) const {
+        return (i < N) ? committed_.counter[i] : 0;
+    } // GetCounter(...)
+
+
+    /**
+     * Get underlying persistent structure of commit record
+     *
+     * \note Use as debugging aid
+     *
+     * \return Reference
+     */
+    Struct<tCommit>& GetStruct() {
+        return ps_;
+    } // GetStruct()
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Clear commit records and staged state
+     */
+    void Clear() {
+        for(uint8_t i = 0; i < N; i++) {
+            committed_.counter[i] = staged_.counter[i] = 0;
+        }
+        staged_mask_ = 0;
+    } // Clear()
+
+
+    /**
+     * Query, can member be staged.  Not staged since last commit and loaded, unless group never committed
+     *
+     * \param[in] i member index
+     * \param[in] loaded member loaded state
+     * \retval true can be staged
+     * \retval false can't
+     */
+    bool IsStageable(const uint8_t i, const bool loaded) const {
+        return i < N && i < 32 && !(staged_mask_ & (1UL << i)) && (loaded || !ps_.IsLoaded());
+    } // IsStageable(...)
+
+
+protected:
+    Struct<tCommit> ps_;
+    tCommit         committed_;
+    tCommit         staged_;
+    uint32_t        staged_mask_;       // Members staged since last commit
+/*! \endcond */
+}; // class Group
+
+} // namespace persist
+
+#endif // PERSISTGROUP_H
@@ -0,0 +1,146 @@
+/**
+ * \file
+ * Slot location hint stores for faster cold load
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTHINT_H
+#define PERSISTHINT_H
+
+
+namespace persist {
+
+/**
+ * Hint store interface.  Records the slot index of the last written data block in a small non volatile
+ * area apart from the storage media (EEPROM words, backup registers), so a cold load can try that slot
+ * before scanning.  Each media type or area will implement this abstract class, see Struct::AttachHint.
+ *
+ * \note A hint is only a hint, it is checked against media headers and may be lost or stale
+ */
+class Hint {
+public:
+    /**
+     * Get recorded slot index
+     *
+     * \param[out] slot index
+     * \retval true recorded slot valid
+     * \retval false nothing recorded or check failed
+     */
+    virtual bool Get(uint16_t &slot) = 0;
+
+
+    /**
+     * Record slot index
+     *
+     * \param[in] slot index
+     * \retval true recorded
+     * \retval false failed
+     */
+    virtual bool Set(const uint16_t slot) = 0;
+}; // class Hint
+
+
+/**
+ * Hint store held in RAM.  Survives nothing, use for host simulation and tests or with RAM preserved
+ * by a supply (RTC RAM)
+ */
+class RamHint : public Hint {
+public:
+    RamHint() : slot_(0), valid_(false), gets_(0), sets_(0) {
+    } // RamHint()
+
+    bool Get(uint16_t &slot) {
+        gets_++;
+        slot = slot_;
+
+        return valid_;
+    } // Get(...)
+
+    bool Set(const uint16_t slot) {
+        sets_++;
+        slot_ = slot;
+        valid_ = true;
+
+        return true;
+    } // Set(...)
+
+    /**
+     * Forget recorded slot
+     */
+    void Invalidate() {
+        valid_ = false;
+    } // Invalidate()
+
+    /**
+     * Get count of calls to \ref Get
+     *
+     * \return N
+     */
+    uint32_t GetGets() const {
+        return gets_;
+    } // GetGets()
+
+    /**
+     * Get count of calls to \ref Set
+     *
+     * \return N
+     */
+    uint32_t GetSets() const {
+        return sets_;
+    } // GetSets()
+
+/*! \cond PRIVATE */
+protected:
+    uint16_t    slot_;
+    bool        valid_;
+    uint32_t    gets_;
+    uint32_t    sets_;
+/*! \endcond */
+}; // class RamHint
+
+
+/**
+ * Hint store via user callbacks, for areas this library has no wrapper for
+ *
+ * \code
+ * bool MyGet(void *context, uint16_t &slot) { ... }
+ * bool MySet(void *context, const uint16_t slot) { ... }
+ *
+ * persist::CallbackHint g_hint(MyGet, MySet);
+ * \endcode
+ */
+class CallbackHint : public Hint {
+public:
+    typedef bool (*tGet)(void *context, uint16_t &slot);
+    typedef bool (*tSet)(void *context, const uint16_t slot);
+
+    /**
+     * Constructor
+     *
+     * \param[in] get callback reading slot
+     * \param[in] set callback recording slot
+     * \param[in] context default NULL.  Passed to callbacks
+     */
+    CallbackHint(tGet get, tSet set, void *context=NULL) : get_(get), set_(set), context_(context) {
+    } // CallbackHint(...)
+
+    bool Get(uint16_t &slot) {
+        return get_ && get_(context_, slot);
+    } // Get(...)
+
+    bool Set(const uint16_t slot) {
+        return set_ && set_(context_, slot);
+    } // Set(...)
+
+/*! \cond PRIVATE */
+protected:
+    tGet    get_;
+    tSet    set_;
+    void    *context_;
+/*! \endcond */
+}; // class CallbackHint
+
+} // namespace persist
+
+#endif // PERSISTHINT_H
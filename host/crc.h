@@ -0,0 +1,229 @@
+/**
+ * \file
+ * Host CRC API, vectorised CRC32 for host tools and Linux media
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Linux
+ */
+
+#ifndef HOSTCRC32_H
+#define HOSTCRC32_H
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HOSTCRC32_CLMUL
+#include <cpuid.h>
+#include <immintrin.h>
+#endif // defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+namespace hostimp {
+
+/**
+ * A class offering crc32 for hosts, same results as swimp::Crc and STM32 CRC unit (CRC-32/BZIP2 of
+ * words, most significant Byte first).  Kernel is selected once at run time from CPUID:
+ * - PCLMULQDQ folding of 4 x 128bits in parallel on x86 CPUs with carry-less multiply
+ * - slicing-by-8 tables otherwise
+ *
+ * \code
+ * uint32_t crc = hostimp::Crc::Generate(slot + 3, words);
+ * \endcode
+ *
+ * \note Class name intentionally generic
+ */
+class Crc {
+public:
+    typedef uint32_t (*tKernel)(const uint32_t *buffer, const uint32_t length_u32);
+
+
+    /**
+     * Algorithm     Poly        Init        RefIn   RefOut  XorOut
+     * CRC-32/BZIP2  0x04C11DB7  0xFFFFFFFF  false   false   0xFFFFFFFF
+     *
+     * \param[in] buffer Pointer to data
+     * \param[in] length_u32 Length of data in sizeof(uint32_t) multiples
+     * \return CRC32 numeric
+     */
+    static uint32_t Generate(const uint32_t *buffer, const uint32_t length_u32) {
+        static const tKernel kernel = Select();
+
+        return kernel(buffer, length_u32);
+    } // Generate(...)
+
+
+    /**
+     * Get name of kernel selected for this CPU
+     *
+     * \return "pclmul" or "slicing8"
+     */
+    static const char* GetKernelName() {
+        return (Select() == GenerateSlicing) ? "slicing8" : "pclmul";
+    } // GetKernelName()
+
+
+    /**
+     * Slicing-by-8 kernel, any CPU
+     *
+     * \param[in] buffer Pointer to data
+     * \param[in] length_u32 Length of data in sizeof(uint32_t) multiples
+     * \return CRC32 numeric
+     */
+    static uint32_t GenerateSlicing(const uint32_t *buffer, const uint32_t length_u32) {
+        return Update(0xffffffffUL, buffer, length_u32) ^ 0xffffffffUL;
+    } // GenerateSlicing(...)
+
+
+#if defined(HOSTCRC32_CLMUL)
+    /**
+     * PCLMULQDQ folding kernel, CPU must have carry-less multiply (see \ref GetKernelName)
+     *
+     * The message is taken as a polynomial of 128bit chunks, words most significant first.  A chunk is
+     * folded onto one d bits further on as H(x) * (x^(d+64) mod P) + L(x) * (x^d mod P), same remainder
+     * modulo P.  Folded to one chunk, its CRC and that of words left over is finished with tables.
+     *
+     * \param[in] buffer Pointer to data
+     * \param[in] length_u32 Length of data in sizeof(uint32_t) multiples
+     * \return CRC32 numeric
+     */
+    __attribute__((target("pclmul,sse2")))
+    static uint32_t GenerateClmul(const uint32_t *buffer, const uint32_t length_u32) {
+        const uint32_t *p = buffer;
+        uint32_t n = length_u32, w[4], crc = 0xffffffffUL;
+        __m128i a0, a1, a2, a3;
+
+        if (n >= 4) {
+            // Init value applied to first word, x^(d+64) high and x^d low quad word fold constants
+            a0 = _mm_xor_si128(Load(p), _mm_set_epi32(-1, 0, 0, 0));
+            if (n >= 32) {
+                a1 = Load(p + 4);
+                a2 = Load(p + 8);
+                a3 = Load(p + 12);
+                p+= 16;
+                n-= 16;
+                for(; n >= 16; p+= 16, n-= 16) {
+                    a0 = _mm_xor_si128(Fold(a0, 0x8833794cULL, 0xe6228b11ULL), Load(p));
+                    a1 = _mm_xor_si128(Fold(a1, 0x8833794cULL, 0xe6228b11ULL), Load(p + 4));
+                    a2 = _mm_xor_si128(Fold(a2, 0x8833794cULL, 0xe6228b11ULL), Load(p + 8));
+                    a3 = _mm_xor_si128(Fold(a3, 0x8833794cULL, 0xe6228b11ULL), Load(p + 12));
+                }
+                a0 = _mm_xor_si128(_mm_xor_si128(Fold(a0, 0x64bf7a9bULL, 0x8c3828a8ULL), Fold(a1, 0x569700e5ULL, 0x75be46b7ULL)),
+                                    _mm_xor_si128(Fold(a2, 0xc5b9cd4cULL, 0xe8a45605ULL), a3));
+            }else {
+                p+= 4;
+                n-= 4;
+            }
+            for(; n >= 4; p+= 4, n-= 4) {
+                a0 = _mm_xor_si128(Fold(a0, 0xc5b9cd4cULL, 0xe8a45605ULL), Load(p));
+            }
+
+            // CRC of chunk, most significant word first, init already in
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(w), _mm_shuffle_epi32(a0, 0x1b));
+            crc = Update(0, w, 4);
+        }
+
+        // Words left over
+        return Update(crc, p, n) ^ 0xffffffffUL;
+    } // GenerateClmul(...)
+#endif // defined(HOSTCRC32_CLMUL)
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Slicing tables, table k is CRC of Byte followed by k zero Bytes
+     */
+    struct tTables {
+        uint32_t t[8][256];
+
+        tTables() {
+            uint32_t i, j, c;
+
+            for(i = 0; i < 256; i++) {
+                for(c = i << 24, j = 0; j < 8; j++) {
+                    c = (c << 1) ^ ((c & 0x80000000UL) ? 0x04c11db7UL : 0);
+                }
+                t[0][i] = c;
+            }
+            for(i = 0; i < 256; i++) {
+                for(j = 1; j < 8; j++) {
+                    t[j][i] = (t[j - 1][i] << 8) ^ t[0][t[j - 1][i] >> 24];
+                }
+            }
+        }
+    };
+
+
+    static const tTables& GetTables() {
+        static const tTables tables;
+
+        return tables;
+    } // GetTables()
+
+
+    /**
+     * Continue CRC over words, no init or final XOR
+     *
+     * \param[in] crc CRC so far
+     * \param[in] buffer Pointer to data
+     * \param[in] length_u32 Length of data in sizeof(uint32_t) multiples
+     * \return CRC
+     */
+    static uint32_t Update(uint32_t crc, const uint32_t *buffer, uint32_t length_u32) {
+        const uint32_t (*t)[256] = GetTables().t;
+
+        for(; length_u32 >= 2; length_u32-= 2, buffer+= 2) {
+            crc^= buffer[0];
+            crc = t[7][crc >> 24] ^ t[6][(crc >> 16) & 0xff] ^ t[5][(crc >> 8) & 0xff] ^ t[4][crc & 0xff] ^
+                    t[3][buffer[1] >> 24] ^ t[2][(buffer[1] >> 16) & 0xff] ^ t[1][(buffer[1] >> 8) & 0xff] ^
+                    t[0][buffer[1] & 0xff];
+        }
+        if (length_u32) {
+            crc^= buffer[0];
+            crc = t[3][crc >> 24] ^ t[2][(crc >> 16) & 0xff] ^ t[1][(crc >> 8) & 0xff] ^ t[0][crc & 0xff];
+        }
+
+        return crc;
+    } // Update(...)
+
+
+#if defined(HOSTCRC32_CLMUL)
+    /**
+     * Load 128bit chunk, first word most significant
+     */
+    __attribute__((target("sse2")))
+    static __m128i Load(const uint32_t *p) {
+        return _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), 0x1b);
+    } // Load(...)
+
+
+    /**
+     * Fold chunk d bits forward, constants x^(d+64) mod P and x^d mod P
+     */
+    __attribute__((target("pclmul,sse2")))
+    static __m128i Fold(const __m128i a, const uint64_t kh, const uint64_t kl) {
+        const __m128i k = _mm_set_epi64x(static_cast<long long>(kh), static_cast<long long>(kl));
+
+        return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x11), _mm_clmulepi64_si128(a, k, 0x00));
+    } // Fold(...)
+#endif // defined(HOSTCRC32_CLMUL)
+
+
+    static tKernel Select() {
+        tKernel kernel = GenerateSlicing;
+#if defined(HOSTCRC32_CLMUL)
+        unsigned int a, b, c, d;
+
+        if (__get_cpuid(1, &a, &b, &c, &d) && (c & bit_PCLMUL)) {
+            kernel = GenerateClmul;
+        }
+#endif // defined(HOSTCRC32_CLMUL)
+
+        return kernel;
+    } // Select()
+/*! \endcond */
+}; // class Crc
+
+} // namespace hostimp
+
+#endif // defined(__linux__)
+
+#endif // HOSTCRC32_H
@@ -0,0 +1,278 @@
+/**
+ * \file
+ * Media wrapper for Linux MTD character devices (raw NOR partition, /dev/mtdN)
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Linux
+ */
+
+#ifndef PERSISTMTD_H
+#define PERSISTMTD_H
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <mtd/mtd-user.h>
+
+#include "media.h"                // Persist base
+#include "host/crc.h"
+
+
+namespace wrap {
+
+/**
+ * Wrapper for a Linux MTD character device.  Geometry is from MEMGETINFO, media pages are MTD erase
+ * blocks.  A program erases every erase block it covers with one MEMERASE (skipped when media already
+ * holds the data), then writes with pwrite and verifies with pread.  Locations are Byte offsets into
+ * the partition, numeric does not represent a valid CPU address.
+ *
+ * Where no MTD is available (no mtdram module, CI) a regular file can stand in.  Given an erase size,
+ * \ref Open emulates MTD on a regular file: erase sets Bytes to 0xff and writes only clear bits, as NOR.
+ *
+ * \code
+ * wrap::Mtd g_mtd;
+ *
+ * if (g_mtd.Open("/dev/mtd3")) {
+ *     persist::Struct<cfg_t> cfg_ps(g_mtd, g_mtd.GetStart(), 4);
+ *     ...
+ * }
+ * \endcode
+ *
+ * \note NOR only, NAND (bad blocks, OOB, page write order) is not handled
+ */
+class Mtd : public persist::Media, protected hostimp::Crc {
+public:
+    Mtd() : fd_(-1), size_(0), erase_size_(0), write_size_(0), emulated_(false), erases_(0) {
+    } // Mtd()
+
+
+    ~Mtd() {
+        Close();
+    } // ~Mtd()
+
+
+    /**
+     * Open MTD device, or a regular file standing in for one
+     *
+     * \param[in] path device or file path
+     * \param[in] emulate_erase_size default 0.  Erase size (Bytes) when path is a regular file, 0 for
+     * MTD devices only
+     * \retval true open, geometry known
+     * \retval false can't open, not MTD or not NOR
+     */
+    bool Open(const char *path, const uint32_t emulate_erase_size=0) {
+        struct mtd_info_user info;
+        struct stat st;
+        bool ok;
+
+        Close();
+        fd_ = open(path, O_RDWR | O_CLOEXEC);
+        ok = fd_ >= 0;
+        if (ok && ioctl(fd_, MEMGETINFO, &info) == 0) {
+            ok = info.type == MTD_NORFLASH && info.erasesize;
+            size_ = info.size;
+            erase_size_ = info.erasesize;
+            write_size_ = info.writesize;
+        }else if (ok) {
+            // Regular file stand in, size whole erase blocks
+            ok = emulate_erase_size && fstat(fd_, &st) == 0 && S_ISREG(st.st_mode);
+            if (ok) {
+                emulated_ = true;
+                erase_size_ = emulate_erase_size;
+                write_size_ = 1;
+                size_ = static_cast<uint32_t>(st.st_size) - static_cast<uint32_t>(st.st_size) % erase_size_;
+                ok = size_ > 0;
+            }
+        }
+        if (!ok) {
+            Close();
+        }
+
+        return ok;
+    } // Open(...)
+
+
+    /**
+     * Close device
+     */
+    void Close() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = -1;
+        size_ = erase_size_ = write_size_ = 0;
+        emulated_ = false;
+    } // Close()
+
+
+    /**
+     * Get MEMERASE (or emulated erase) calls made
+     *
+     * \return N
+     */
+    uint32_t GetErases() const {
+        return erases_;
+    } // GetErases()
+
+
+    uint32_t GetPageSize() const {
+        return erase_size_;
+    }
+
+    uint32_t GetProgramSize() const {
+        return write_size_;
+    }
+
+    uint32_t GetSize() const {
+        return size_;
+    }
+
+    uint32_t* const GetStart() const {
+        return 0;
+    }
+
+    uint32_t* const GetEnd() const {
+        return GetStart() + (GetSize()>>2);
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        uint32_t a = GetAddress(buffer), e = a + (static_cast<uint32_t>(size_u32)<<2), s;
+        bool done;
+
+        (void)page_size_u32;
+        (void)use_lock;
+
+        // Already written?
+        done = Verify(a, data, size_u32);
+        if (!done) {
+            // One erase of every erase block covered, write and verify
+            s = a - (a % erase_size_);
+            done = EraseRange(s, ((e - s + erase_size_ - 1) / erase_size_) * erase_size_) && \
+                    Write(buffer, data, size_u32) && Verify(a, data, size_u32);
+        }
+
+        return done;
+    } // Program(...)
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint32_t n = static_cast<uint32_t>(size_u32)<<2;
+
+        return fd_ >= 0 && GetAddress(buffer) + n <= size_ && \
+                pread(fd_, const_cast<uint32_t*>(data), n, GetAddress(buffer)) == static_cast<ssize_t>(n);
+    } // Read(...)
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return hostimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint32_t w[64];
+        uint32_t a = GetAddress(buffer), n = static_cast<uint32_t>(size_u32)<<2, i, j, k;
+        bool done = fd_ >= 0 && a + n <= size_;
+
+        if (done && emulated_) {
+            // NOR, bits only cleared
+            for(i = 0; done && i < static_cast<uint32_t>(size_u32); i+= j) {
+                j = (static_cast<uint32_t>(size_u32) - i > 64) ? 64 : static_cast<uint32_t>(size_u32) - i;
+                done = pread(fd_, w, j<<2, a + (i<<2)) == static_cast<ssize_t>(j<<2);
+                for(k = 0; done && k < j; k++) {
+                    w[k]&= data[i + k];
+                }
+                done = done && pwrite(fd_, w, j<<2, a + (i<<2)) == static_cast<ssize_t>(j<<2);
+            }
+        }else if (done) {
+            done = pwrite(fd_, data, n, a) == static_cast<ssize_t>(n);
+        }
+
+        return done;
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        return EraseRange(GetAddress(buffer), pages * erase_size_);
+    } // Erase(...)
+
+/*! \cond PRIVATE */
+protected:
+    static uint32_t GetAddress(const uint32_t *buffer) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(buffer));
+    } // GetAddress(...)
+
+
+    /**
+     * Erase range with one MEMERASE
+     *
+     * \param[in] address erase block aligned Byte address
+     * \param[in] bytes erase block multiple
+     * \retval true on success
+     * \retval false not aligned, beyond device or failed
+     */
+    bool EraseRange(const uint32_t address, const uint32_t bytes) {
+        struct erase_info_user ei;
+        uint8_t e[256];
+        uint32_t i, n;
+        bool done = fd_ >= 0 && erase_size_ && !(address % erase_size_) && !(bytes % erase_size_) && \
+                    address + bytes <= size_;
+
+        if (done) {
+            erases_++;
+            if (emulated_) {
+                memset(e, 0xff, sizeof(e));
+                for(i = 0; done && i < bytes; i+= n) {
+                    n = (bytes - i > sizeof(e)) ? sizeof(e) : bytes - i;
+                    done = pwrite(fd_, e, n, address + i) == static_cast<ssize_t>(n);
+                }
+            }else {
+                ei.start = address;
+                ei.length = bytes;
+                done = ioctl(fd_, MEMERASE, &ei) == 0;
+            }
+        }
+
+        return done;
+    } // EraseRange(...)
+
+
+    /**
+     * Query, media at Byte address matches data
+     *
+     * \param[in] address Byte address
+     * \param[in] data pointer to data
+     * \param[in] size_u32 size of data, sizeof(uint32_t) multiples
+     * \retval true same
+     * \retval false different or read failure
+     */
+    bool Verify(uint32_t address, const uint32_t *data, const int16_t size_u32) {
+        uint32_t buffer[64];
+        int16_t i, n;
+        bool ok = true;
+
+        for(i = 0; ok && i < size_u32; i+= n, address+= n<<2) {
+            n = (size_u32 - i > 64) ? 64 : static_cast<int16_t>(size_u32 - i);
+            ok = Read(reinterpret_cast<uint32_t*>(static_cast<uintptr_t>(address)), buffer, n) && \
+                    !memcmp(buffer, data + i, n<<2);
+        }
+
+        return ok;
+    } // Verify(...)
+
+
+protected:
+    int         fd_;
+    uint32_t    size_;              // Partition size, Bytes
+    uint32_t    erase_size_;        // Media page, Bytes
+    uint32_t    write_size_;        // Minimum write, Bytes
+    bool        emulated_;          // Regular file stand in
+    uint32_t    erases_;
+/*! \endcond */
+}; // class Mtd
+
+} // namespace wrap
+
+#endif // defined(__linux__)
+
+#endif // PERSISTMTD_H
@@ -0,0 +1,165 @@
+/**
+ * \file
+ * Test of read cache media decorator, I2C EEPROM wrapper against host emulator.  Build with any C++
+ * compiler, e.g. "g++ -I.. cachetest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../cache.h"
+#include "../ext/i2cee.h"
+#include "../struct.h"
+#include "i2ceesim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    serial;
+    uint16_t    rate;
+    uint8_t     name[34];
+}cfg_t;
+
+I2cEeSim<32768, 64> g_sim;          // 24LC256
+uint32_t g_reads = 0, g_read_bytes = 0;
+
+
+/**
+ * I2C bus time of reads at 400kHz, us.  Per read start, control, 2 address Bytes, restart, control and
+ * stop, 9 bits a Byte
+ */
+static uint32_t BusTime(const uint32_t reads, const uint32_t bytes) {
+    return ((reads * 4 + bytes) * 9 + reads * 3) * 5 / 2;
+}
+
+
+/**
+ * Count read transactions (bus traffic) then pass to emulator
+ */
+static bool Transfer(void *context, const uint8_t device, const uint8_t *address, const uint8_t address_size,
+                        const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+    if (rx) {
+        g_reads++;
+        g_read_bytes+= size;
+    }
+
+    return I2cEeSim<32768, 64>::Transfer(context, device, address, address_size, tx, rx, size);
+}
+
+
+int main() {
+    wrap::I2cEe ee(Transfer, &g_sim, 0x50, 32768, 64);
+    cfg_t c, d;
+    uint32_t b[16], r[16], i, direct, bytes, cached;
+
+    // Line served from cache, program drops it
+    {
+        persist::Cache<64, 2> cache(ee);
+
+        for(i = 0; i < 16; i++) {
+            b[i] = i;
+        }
+        CHECK(cache.Program(cache.GetStart() + 16, b, 16, 0, false));
+        CHECK(cache.Read(cache.GetStart() + 16, r, 16) && !memcmp(b, r, sizeof(b)));
+        CHECK(cache.Read(cache.GetStart() + 20, r, 4) && r[0] == 4);
+        CHECK(cache.GetMisses() == 1 && cache.GetHits() == 1);
+        b[4] = 44;
+        CHECK(cache.Program(cache.GetStart() + 16, b, 16, 0, false));
+        CHECK(cache.Read(cache.GetStart() + 20, r, 1) && r[0] == 44 && cache.GetMisses() == 2);
+
+        // Across lines, only Bytes missing read: one span of first line, both sides of second's
+        g_read_bytes = 0;
+        CHECK(cache.Read(cache.GetStart() + 8, r, 16) && !memcmp(r + 8, b, 8 * sizeof(uint32_t)));
+        CHECK(cache.GetMisses() == 5 && g_read_bytes == 15 * sizeof(uint32_t));
+        CHECK(cache.Read(cache.GetStart() + 12, r, 12) && cache.GetMisses() == 5);
+
+        // Span apart from valid span replaces it, least recently used line replaced
+        CHECK(cache.Read(cache.GetStart() + 30, r, 2) && r[0] == 14 && cache.GetMisses() == 6);
+        CHECK(cache.Read(cache.GetStart() + 16, r, 1) && cache.GetMisses() == 7);
+        CHECK(cache.Read(cache.GetStart() + 32, r, 1) && cache.GetMisses() == 8);
+        CHECK(cache.Read(cache.GetStart() + 16, r, 1) && cache.GetMisses() == 8);
+        CHECK(cache.Read(cache.GetStart() + 8, r, 1) && cache.GetMisses() == 9);
+    }
+
+    // Structure saves, ware level 8
+    {
+        persist::Struct<cfg_t> ps(ee, ee.GetStart(), 8);
+
+        memset(&c, 0, sizeof(c));
+        CHECK(ps.Save(c, true));
+        for(i = 1; i <= 13; i++) {
+            c.serial = i;
+            CHECK(ps.Save(c));
+        }
+    }
+
+    // Cold load direct
+    {
+        persist::Struct<cfg_t> ps(ee, ee.GetStart(), 8);
+
+        g_reads = g_read_bytes = 0;
+        CHECK(ps.Load(d) && !memcmp(&c, &d, sizeof(c)));
+        direct = g_reads;
+        bytes = g_read_bytes;
+    }
+
+    // Cold load through cache, header of newest slot not read again.  Never more Bytes than direct
+    {
+        persist::Cache<64, 4> cache(ee);          // Line per slot
+        persist::Struct<cfg_t> ps(cache, cache.GetStart(), 8);
+
+        g_reads = g_read_bytes = 0;
+        CHECK(ps.Load(d) && !memcmp(&c, &d, sizeof(c)));
+        std::cout << "cold load   = " << direct << " reads (" << bytes << " Bytes) direct, " << g_reads << " reads (" << \
+                        g_read_bytes << " Bytes) cached, " << cache.GetHits() << " hits, " << cache.GetMisses() << \
+                        " misses" << std::endl;
+        CHECK(g_reads <= direct && g_read_bytes + sizeof(persist::HeadStd::tHead) == bytes);
+        cached = BusTime(g_reads, g_read_bytes);
+
+        // Repeated loads and field reads without bus access
+        g_reads = 0;
+        for(i = 0; i < 4; i++) {
+            CHECK(ps.Load(d) && ps.ReadField(&cfg_t::rate, d.rate));
+        }
+        CHECK(g_reads == 0);
+
+        // Save through cache then load again from media
+        c.serial = 99;
+        CHECK(ps.Save(c));
+        persist::Struct<cfg_t> again(cache, cache.GetStart(), 8);
+        CHECK(again.Load(d) && d.serial == 99);
+    }
+
+    // Cold load reading ahead, headers of 4 slots a read.  At least halves reads, costs bus time on I2C
+    {
+        persist::Cache<256, 2> cache(ee);
+        persist::Struct<cfg_t> ps(cache, cache.GetStart(), 8);
+
+        cache.SetReadAhead(true);
+        g_reads = g_read_bytes = 0;
+        CHECK(ps.Load(d) && d.serial == 99);
+        std::cout << "read ahead  = " << g_reads << " reads (" << g_read_bytes << " Bytes), " << cache.GetHits() << \
+                        " hits, " << cache.GetMisses() << " misses" << std::endl;
+        std::cout << "bus time    = " << BusTime(direct, bytes) << " us direct, " << cached << " us cached, " << \
+                        BusTime(g_reads, g_read_bytes) << " us read ahead (I2C 400kHz)" << std::endl;
+        CHECK(g_reads * 2 <= direct && g_read_bytes == 8 * 64);
+        CHECK(cached < BusTime(direct, bytes) && BusTime(g_reads, g_read_bytes) > BusTime(direct, bytes));
+
+        // Repeated load without bus access
+        g_reads = 0;
+        CHECK(ps.Load(d) && g_reads == 0);
+    }
+
+    CHECK(!g_sim.GetViolations());
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
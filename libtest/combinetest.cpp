@@ -0,0 +1,146 @@
+/**
+ * \file
+ * Test of write combining media decorator, I2C EEPROM wrapper against host emulator.  Build with any
+ * C++ compiler, e.g. "g++ -I.. combinetest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../combine.h"
+#include "../ext/i2cee.h"
+#include "../struct.h"
+#include "i2ceesim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+// Rounds, saves of each structure per round (field edits)
+#define ROUNDS            10
+#define EDITS             4
+
+typedef struct {
+    uint32_t    address;
+    uint16_t    port;
+    uint8_t     name[34];
+}net_t;
+
+typedef struct {
+    uint32_t    serial;
+    uint8_t     key[32];
+}cred_t;
+
+I2cEeSim<32768, 64> g_sim;          // 24LC256
+uint32_t g_transactions = 0;
+
+
+/**
+ * Count bus transactions, not ACK polls, then pass to emulator
+ */
+static bool Transfer(void *context, const uint8_t device, const uint8_t *address, const uint8_t address_size,
+                        const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+    if (address_size) {
+        g_transactions++;
+    }
+
+    return I2cEeSim<32768, 64>::Transfer(context, device, address, address_size, tx, rx, size);
+}
+
+
+/**
+ * Save both structures EDITS times a round, flushing after each round when combined
+ *
+ * \return bus transactions
+ */
+template<typename M>
+static uint32_t Run(M &m, persist::Combine<256> *combine) {
+    persist::Struct<net_t> net_ps(m, m.GetStart(), 2);
+    persist::Struct<cred_t> cred_ps(m, m.GetStart() + (128>>2), 2);
+    net_t net;
+    cred_t cred;
+    uint32_t i, j;
+
+    memset(&net, 0, sizeof(net));
+    memset(&cred, 0, sizeof(cred));
+    g_transactions = 0;
+    for(i = 0; i < ROUNDS; i++) {
+        for(j = 0; j < EDITS; j++) {
+            net.port = static_cast<uint16_t>(i * EDITS + j);
+            cred.serial = i * EDITS + j;
+            if (!net_ps.Save(net, !i && !j) || !cred_ps.Save(cred, !i && !j)) {
+                return 0;
+            }
+        }
+        if (combine && !combine->Flush()) {
+            return 0;
+        }
+    }
+
+    return g_transactions;
+}
+
+
+int main() {
+    wrap::I2cEe ee(Transfer, &g_sim, 0x50, 32768, 64);
+    uint32_t b[8], r[8], i, direct, combined;
+
+    // Gathered in unit, read from unit, programmed on flush
+    {
+        persist::Combine<256> combine(ee);
+
+        for(i = 0; i < 8; i++) {
+            b[i] = i + 1;
+        }
+        CHECK(combine.Program(combine.GetStart() + 4, b, 4, 0, false));
+        CHECK(combine.Program(combine.GetStart() + 40, b + 4, 4, 0, false));
+        CHECK(combine.GetPrograms() == 0 && combine.GetCombined() == 2);
+        CHECK(combine.Read(combine.GetStart() + 40, r, 4) && !memcmp(r, b + 4, 4 * sizeof(uint32_t)));
+        CHECK(ee.Read(ee.GetStart() + 40, r, 4) && r[0] == ee.GetEraseState());
+        CHECK(combine.Flush() && combine.GetPrograms() == 2);
+        CHECK(ee.Read(ee.GetStart() + 4, r, 4) && !memcmp(r, b, 4 * sizeof(uint32_t)));
+        CHECK(ee.Read(ee.GetStart() + 40, r, 4) && !memcmp(r, b + 4, 4 * sizeof(uint32_t)));
+
+        // Read across unit boundary overlays unit, program to next unit flushes
+        CHECK(combine.Program(combine.GetStart() + 60, b, 4, 0, false));
+        CHECK(combine.Read(combine.GetStart() + 60, r, 8) && !memcmp(r, b, 4 * sizeof(uint32_t)));
+        CHECK(combine.Program(combine.GetStart() + 64, b + 4, 4, 0, false) && combine.GetPrograms() == 3);
+        CHECK(ee.Read(ee.GetStart() + 60, r, 4) && !memcmp(r, b, 4 * sizeof(uint32_t)));
+
+        // Erase flushes first
+        CHECK(combine.Erase(combine.GetStart() + 64, 1) && combine.GetPrograms() == 4);
+        CHECK(ee.Read(ee.GetStart() + 64, r, 1) && r[0] == ee.GetEraseState());
+    }
+
+    // Two structures in one unit, saved together
+    memset(g_sim.GetMemory(), 0xff, 32768);
+    direct = Run(ee, NULL);
+    {
+        persist::Combine<256> combine(ee);
+
+        memset(g_sim.GetMemory(), 0xff, 32768);
+        combined = Run(combine, &combine);
+        std::cout << "saves       = " << 2 * ROUNDS * EDITS << ", " << direct << " transactions direct, " << combined << \
+                        " combined, " << combine.GetPrograms() << " programs" << std::endl;
+        CHECK(combined && combined < direct && combine.GetPrograms() == ROUNDS);
+
+        persist::Struct<net_t> net_ps(ee, ee.GetStart(), 2);
+        persist::Struct<cred_t> cred_ps(ee, ee.GetStart() + (128>>2), 2);
+        net_t net;
+        cred_t cred;
+
+        CHECK(net_ps.Load(net) && net.port == ROUNDS * EDITS - 1);
+        CHECK(cred_ps.Load(cred) && cred.serial == ROUNDS * EDITS - 1);
+    }
+
+    CHECK(!g_sim.GetViolations());
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
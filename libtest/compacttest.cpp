@@ -0,0 +1,119 @@
+/**
+ * \file
+ * Test of compact header policy, save and load, 16bit counter wrap, 16bit CRC fold with implicit size check
+ * and random media in a slot.
+ * Build with any C++ compiler, e.g. "g++ -I.. compacttest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    value;
+    uint8_t     mode;
+}cfg_t;
+
+typedef persist::Struct<cfg_t, persist::HeadCompact> ps_t;
+
+
+int main() {
+    FlashSim<64, 8> sim;
+    persist::HeadCompact::tHead h;
+    uint32_t i, n;
+    cfg_t c, l;
+
+    CHECK(ps_t::GetStorageUnitSize() == 12);
+
+    // Wrap, serial number arithmetic
+    CHECK(persist::HeadCompact::IsNewer(1, 0) && !persist::HeadCompact::IsNewer(0, 1) && !persist::HeadCompact::IsNewer(5, 5));
+    CHECK(persist::HeadCompact::IsNewer(0, 0xffff) && persist::HeadCompact::IsNewer(3, 0xfffe));
+    CHECK(!persist::HeadCompact::IsNewer(0xffff, 0));
+
+    // Erase state never sane, other data block size and invalidated never sealed
+    memset(&h, 0xff, sizeof(h));
+    CHECK(!persist::HeadCompact::IsSane(h, 8));
+    persist::HeadCompact::Seal(h, 0x12345678UL, 8);
+    CHECK(persist::HeadCompact::IsSane(h, 8) && persist::HeadCompact::IsSealed(h, 0x12345678UL, 8));
+    CHECK(!persist::HeadCompact::IsSealed(h, 0x12345678UL, 12) && !persist::HeadCompact::IsSealed(h, 0x12345678UL, 4));
+    persist::HeadCompact::Invalidate(h);
+    CHECK(!persist::HeadCompact::IsSealed(h, 0x12345678UL, 8));
+    for(i = 0; i < 0x10000; i++) {
+        persist::HeadCompact::Seal(h, i, 8);
+        CHECK(persist::HeadCompact::IsSane(h, 8));
+    }
+
+    // Any single bit CRC error detected
+    persist::HeadCompact::Seal(h, 0x12345678UL, 8);
+    for(i = 0; i < 32; i++) {
+        CHECK(!persist::HeadCompact::IsSealed(h, 0x12345678UL ^ (1UL << i), 8));
+    }
+
+    // Random CRC accepted about 1 in 65536, full 16bit check
+    srand(1);
+    for(i = n = 0; i < 1000000; i++) {
+        n+= persist::HeadCompact::IsSealed(h, (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand()), 8) ? 1 : 0;
+    }
+    CHECK(n < 40);
+
+    // Save and load
+    memset(&c, 0, sizeof(c));
+    c.value = 1;
+    {
+        ps_t ps(sim, sim.GetStart(), 8);
+
+        CHECK(!ps.Load(l));
+        CHECK(ps.Save(c, true) && ps.GetCounter() == 0);
+        c.value = 2;
+        CHECK(ps.Save(c) && ps.GetCounter() == 1);
+    }
+    {
+        ps_t ps(sim, sim.GetStart(), 8);
+
+        CHECK(ps.Load(l) && l.value == 2 && ps.GetCounter() == 1);
+
+        // Through 16bit counter wrap, newest found after each reload
+        for(i = 3; i < 0x10000 + 20; i++) {
+            c.value = i;
+            CHECK(ps.Save(c));
+            if (ps.GetCounter() > 0xfff8 || ps.GetCounter() < 8) {
+                ps_t r(sim, sim.GetStart(), 8);
+
+                CHECK(r.Load(l) && l.value == i && r.GetCounter() == ps.GetCounter());
+            }
+        }
+        CHECK(ps.GetCounter() == ((0x10000 + 19 - 1) & 0xffff));
+    }
+
+    // Random data in an older slot, still newest loaded
+    {
+        ps_t ps(sim, sim.GetStart(), 8);
+        uint8_t *m = sim.GetMemory() + ((ps.GetLocation() - sim.GetStart()) * sizeof(uint32_t) + 192) % 512;
+
+        CHECK(ps.Load(l));
+        for(i = 0; i < 12; i++) {
+            m[i] = static_cast<uint8_t>(rand());
+        }
+    }
+    {
+        ps_t ps(sim, sim.GetStart(), 8);
+
+        CHECK(ps.Load(l) && l.value == 0x10000 + 19);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,185 @@
+/**
+ * \file
+ * Test of run length codec round trip and compressed persistent structure, record size following the
+ * compressed length and raw fallback when data doesn't compress.  Build with any C++ compiler,
+ * e.g. "g++ -I.. compresstest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "../compress.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    version;
+    uint8_t     lookup[2048];
+}table_t;
+
+typedef persist::Compressed<table_t> zip_t;
+
+FlashSim<1024, 12> g_sim;
+uint8_t g_image[1024 * 12];
+
+
+/**
+ * Encode then decode, compare
+ *
+ * \return Compressed length, 0 on mismatch or won't fit
+ */
+static uint32_t RoundTrip(const uint8_t *src, const uint32_t len, const uint32_t dst_max) {
+    static uint8_t z[4096], d[4096];
+    uint32_t n = persist::Rle::Encode(src, len, z, dst_max);
+
+    if (len && (!n || !persist::Rle::Decode(z, n, d, len) || memcmp(src, d, len))) {
+        n = 0;
+    }
+
+    return n;
+}
+
+
+int main() {
+    static uint8_t b[1024];
+    static table_t t, l;
+    uint32_t i, n, counter;
+    bool done;
+
+    // Empty
+    CHECK(persist::Rle::Encode(b, 0, b, 0) == 0);
+    CHECK(persist::Rle::Decode(b, 0, b, 0));
+
+    // No runs, literal blocks of 128
+    for(i = 0; i < sizeof(b); i++) {
+        b[i] = static_cast<uint8_t>(i * 7 + (i >> 3));
+    }
+    n = RoundTrip(b, 300, sizeof(b));
+    CHECK(n == 300 + 3);
+
+    // Maximum runs, 130 per control byte, remainder below 3 as literal
+    memset(b, 0x5a, sizeof(b));
+    CHECK(RoundTrip(b, 130, 2) == 2);
+    CHECK(RoundTrip(b, 260, sizeof(b)) == 4);
+    CHECK(RoundTrip(b, 131, sizeof(b)) == 4);
+    CHECK(RoundTrip(b, 1024, sizeof(b)) == 16);
+
+    // Output full, both run and literal
+    CHECK(persist::Rle::Encode(b, 260, b + 512, 3) == 0);
+    for(i = 0; i < sizeof(b); i++) {
+        b[i] = static_cast<uint8_t>(i * 7 + (i >> 3));
+    }
+    CHECK(persist::Rle::Encode(b, 100, b + 512, 100) == 0);
+    CHECK(RoundTrip(b, 100, 101) == 101);
+
+    // Corrupt source or length mismatch
+    b[0] = 10;
+    CHECK(!persist::Rle::Decode(b, 5, b + 512, 20));
+    b[0] = 200;
+    CHECK(!persist::Rle::Decode(b, 1, b + 512, 75));
+    CHECK(!persist::Rle::Decode(b, 2, b + 512, 74));
+
+    // Compressible table, 1 page records so all pages used rather than 3 pages per copy
+    memset(&t, 0, sizeof(t));
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(!ps.Load(l));
+        CHECK(ps.Save(t, true));
+        CHECK(!ps.IsRaw() && ps.GetBytes() < 64);
+        for(i = 1; i < 12; i++) {
+            t.version = i;
+            CHECK(ps.Save(t));
+            CHECK(ps.GetLocation() == g_sim.GetStart() + i * (1024>>2));
+        }
+        t.version = 12;
+        CHECK(ps.Save(t) && ps.GetLocation() == g_sim.GetStart());
+    }
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(ps.Load(l) && !memcmp(&l, &t, sizeof(t)) && ps.GetCounter() == 12);
+    }
+
+    // Doesn't compress, stored raw over 3 pages and still saved
+    for(i = 0; i < sizeof(t.lookup); i++) {
+        t.lookup[i] = static_cast<uint8_t>(i * 7 + (i >> 3));
+    }
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(ps.Load(l));
+        t.version = 13;
+        CHECK(ps.Save(t) && ps.IsRaw() && ps.GetBytes() == sizeof(t));
+        CHECK(ps.GetLocation() == g_sim.GetStart() + (1024>>2));
+        t.version = 14;
+        CHECK(ps.Save(t) && ps.GetLocation() == g_sim.GetStart() + 4 * (1024>>2));
+    }
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(ps.Load(l) && !memcmp(&l, &t, sizeof(t)) && ps.IsRaw() && ps.GetCounter() == 14);
+    }
+
+    // Corrupt newest, previous loaded
+    g_sim.GetMemory()[4 * 1024 + 100]^= 1;
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(ps.Load(l) && ps.GetCounter() == 13 && l.version == 13);
+    }
+    g_sim.GetMemory()[4 * 1024 + 100]^= 1;
+
+    // Power cut after each write or erase of a save, old or new loaded
+    memcpy(g_image, g_sim.GetMemory(), sizeof(g_image));
+    for(n = 0, done = false; !done; n++) {
+        memcpy(g_sim.GetMemory(), g_image, sizeof(g_image));
+        {
+            zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+            CHECK(ps.Load(t));
+            memset(t.lookup, 0x33, sizeof(t.lookup));
+            t.version = 15;
+            g_sim.CutAfter(static_cast<int32_t>(n));
+            done = ps.Save(t);
+            g_sim.Restore();
+        }
+        {
+            zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+            CHECK(ps.Load(l));
+            counter = ps.GetCounter();
+            CHECK((counter == 14 && l.version == 14) || (counter == 15 && l.version == 15 && l.lookup[9] == 0x33));
+            CHECK(!done || counter == 15);
+        }
+    }
+
+    // Write failure, moves to following pages
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(ps.Load(t));
+        t.version = 16;
+        g_sim.FailNext(1);
+        CHECK(ps.Save(t) && ps.GetCounter() == 16);
+    }
+    {
+        zip_t ps(g_sim, g_sim.GetStart(), g_sim.GetEnd());
+
+        CHECK(ps.Load(l) && l.version == 16);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,143 @@
+/**
+ * \file
+ * Test of high endurance counter, word and bit mode, page switch, reboot at every count including part
+ * way into a page and power cut during increment or page switch.  Build with any C++ compiler,
+ * e.g. "g++ -I.. countertest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../counter.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+
+/**
+ * Count through several page switches, reloading after each increment, then power cut at each write
+ * or erase of an increment
+ *
+ * \return 0 pass, 1 fail
+ */
+static int Run(const bool bits) {
+    FlashSim<64, 2> sim;
+    uint32_t i, n, value = 0, erases;
+    bool done;
+
+    {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        CHECK(c.Load() && c.Get() == 0);
+        CHECK(c.GetUnitsPerPage() == (bits ? 14 * 32 : 14));
+    }
+
+    // Reboot after every increment, value from header base plus units found by search
+    for(i = 0; i < 5 * (bits ? 14 * 32 : 14) + 3; i++) {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        CHECK(c.Load() && c.Get() == value);
+        CHECK(c.Increment() && c.Get() == ++value);
+    }
+
+    // One erase per page of units
+    sim.Clear();
+    {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        for(i = 0; i < 3 * c.GetUnitsPerPage(); i++) {
+            CHECK(c.Increment());
+            value++;
+        }
+        CHECK(c.Get() == value);
+    }
+    erases = sim.GetErases();
+    CHECK(erases == 3);
+
+    // Power cut at each point, value never lost or going back, at most the cut increment missing
+    for(n = 0; n < 3 * (bits ? 14 * 32 : 14); n++) {
+        {
+            persist::Counter c(sim, sim.GetStart(), bits);
+
+            CHECK(c.Load() && c.Get() == value);
+            sim.CutAfter(static_cast<int32_t>(n % 3));
+            for(done = true; done; ) {
+                done = c.Increment();
+                value+= done ? 1 : 0;
+            }
+            sim.Restore();
+        }
+        {
+            persist::Counter c(sim, sim.GetStart(), bits);
+
+            CHECK(c.Load() && c.Get() == value);
+        }
+    }
+
+    // Power cut in page switch, at erase of other page and at its header write
+    {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        CHECK(c.Load());
+        while(c.Get() % c.GetUnitsPerPage()) {
+            CHECK(c.Increment());
+            value++;
+        }
+    }
+    for(n = 0; n < 2; n++) {
+        {
+            persist::Counter c(sim, sim.GetStart(), bits);
+
+            CHECK(c.Load() && c.Get() == value);
+            sim.CutAfter(static_cast<int32_t>(n));
+            CHECK(!c.Increment());
+            sim.Restore();
+        }
+        {
+            persist::Counter c(sim, sim.GetStart(), bits);
+
+            CHECK(c.Load() && c.Get() == value);
+        }
+    }
+    {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        CHECK(c.Load() && c.Increment() && c.Get() == ++value);
+    }
+
+    // Failed write not counted, next increment takes that unit
+    {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        CHECK(c.Load());
+        sim.FailNext(1);
+        CHECK(!c.Increment() && c.Get() == value);
+        CHECK(c.Increment() && c.Get() == ++value);
+    }
+    {
+        persist::Counter c(sim, sim.GetStart(), bits);
+
+        CHECK(c.Load() && c.Get() == value);
+    }
+
+    return 0;
+}
+
+
+int main() {
+    if (Run(false) || Run(true)) {
+        return 1;
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,106 @@
+/**
+ * \file
+ * Benchmark for host CRC32 kernels against the table CRC of sw/crc.h, results checked bit identical first.
+ * Host build, no media access.  Build on Linux with any C++ compiler, e.g. "g++ -O2 -I.. crcbench.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Linux
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+
+#include "../sw/crc.h"
+#include "../host/crc.h"
+
+// Buffer, words.  Slot size, words (persist::Struct of a 52 Byte ADT)
+#define BUFFER_U32        (1UL << 22)
+#define SLOT_U32          13
+#define CHECK_U32         300
+
+typedef uint32_t (*kernel_t)(const uint32_t *buffer, const uint32_t length_u32);
+
+
+/**
+ * Time kernel over buffer in blocks of given size
+ *
+ * \return MB/s
+ */
+static double Run(kernel_t kernel, const uint32_t *buffer, const uint32_t block_u32, uint32_t &sum) {
+    uint32_t i, n = 0;
+    clock_t t0 = clock(), t1;
+
+    do {
+        for(i = 0; i + block_u32 <= BUFFER_U32; i+= block_u32, n++) {
+            sum+= kernel(buffer + i, block_u32);
+        }
+        t1 = clock();
+    }while(t1 - t0 < CLOCKS_PER_SEC / 4);
+
+    return static_cast<double>(n) * block_u32 * sizeof(uint32_t) / 1e6 / (static_cast<double>(t1 - t0) / CLOCKS_PER_SEC);
+}
+
+
+/**
+ * Benchmark entry point
+ *
+ * @return int Status
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main() {
+    static const struct {
+        const char  *name;
+        kernel_t    kernel;
+        bool        clmul;          // Needs carry-less multiply
+    }kernels[] = {
+        {"table (sw/crc.h)", swimp::Crc::Generate, false},
+        {"slicing-by-8", hostimp::Crc::GenerateSlicing, false},
+#if defined(HOSTCRC32_CLMUL)
+        {"pclmul", hostimp::Crc::GenerateClmul, true},
+#endif // defined(HOSTCRC32_CLMUL)
+        {"Generate", hostimp::Crc::Generate, false}
+    };
+    uint32_t *buffer = new uint32_t[BUFFER_U32], sum = 0, i, j, k;
+    bool pclmul = !strcmp(hostimp::Crc::GetKernelName(), "pclmul");
+
+    srand(1);
+    for(i = 0; i < BUFFER_U32; i++) {
+        buffer[i] = (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand());
+    }
+
+    // Bit identical to sw/crc.h, every length up to a few folds at several offsets
+    for(k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (kernels[k].clmul && !pclmul) {
+            continue;
+        }
+        for(i = 0; i < 4; i++) {
+            for(j = 0; j <= CHECK_U32; j++) {
+                if (kernels[k].kernel(buffer + i, j) != swimp::Crc::Generate(buffer + i, j)) {
+                    std::cerr << "ERROR: " << kernels[k].name << " mismatch, offset " << i << " length " << j << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    std::cout << "kernel selected     " << hostimp::Crc::GetKernelName() << std::endl;
+    std::cout << std::left << std::setw(20) << "MB/s" << std::right << std::setw(12) << "slot" << std::setw(12) << "4 KB" <<
+                    std::setw(12) << "16 MB" << std::endl;
+    for(k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (kernels[k].clmul && !pclmul) {
+            continue;
+        }
+        std::cout << std::left << std::setw(20) << kernels[k].name << std::right << std::fixed << std::setprecision(0) <<
+                        std::setw(12) << Run(kernels[k].kernel, buffer, SLOT_U32, sum) <<
+                        std::setw(12) << Run(kernels[k].kernel, buffer, 1024, sum) <<
+                        std::setw(12) << Run(kernels[k].kernel, buffer, BUFFER_U32, sum) << std::endl;
+    }
+    std::cout << "(checksum " << std::hex << sum << ")" << std::endl;
+    delete[] buffer;
+
+    return 0;
+} // int main(...)
@@ -0,0 +1,202 @@
+/**
+ * \file
+ * Benchmark of AVR EEPROM Byte writes, parameter ring (wrap::EeRing) against persist::Struct on the
+ * dword update path of wrap::Ee, for the same number of copies.  Host build against EEPROM emulator.
+ * Build with any C++ compiler, e.g. "g++ -I.. eeringbench.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+// Software CRC32, AVR EEPROM API from emulator
+#define ARDUINO_ARCH_STM32
+#define ARDUINO_ARCH_AVR
+
+#include "eesim.h"
+#include "../media.h"
+#include "../sw/crc.h"
+#include "../struct.h"
+#include "../mega/eering.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+// Saves per run, copies of parameter
+#define SAVES             1000
+#define COPIES            8
+
+/**
+ * Calibration resembling a small application parameter, one field changes per save
+ */
+typedef struct {
+    uint32_t    serial;
+    int16_t     offset;
+    int16_t     gain;
+    uint16_t    runs;
+    uint8_t     mode;
+    uint8_t     spare[5];
+}cal_t;
+
+
+/**
+ * Media as wrap::Ee (mega/wrap.h needs avr-libc headers), dword update and read back per word
+ *
+ * \tparam PSZ page size (Bytes)
+ */
+template<uint16_t PSZ>
+class EeDword : public persist::Media, protected swimp::Crc {
+public:
+    uint32_t GetPageSize() const {
+        return PSZ;
+    }
+
+    uint32_t GetSize() const {
+        return E2END+1;
+    }
+
+    uint32_t* const GetStart() const {
+        return 0;
+    }
+
+    uint32_t* const GetEnd() const {
+        return GetStart() + (GetSize()>>2);
+    }
+
+    bool Program(const uint32_t* buffer, const uint32_t* data, const int16_t size_u32,
+                                const uint32_t page_size_u32, const bool use_lock) {
+        uint32_t *b = const_cast<uint32_t*>(buffer);
+        int16_t i;
+        bool ok = true;
+
+        (void)page_size_u32;
+        (void)use_lock;
+
+        for(i = 0; ok && i < size_u32; i++) {
+            eeprom_update_dword(&b[i], data[i]);
+            ok = eeprom_read_dword(&b[i]) == data[i];
+        }
+
+        return ok;
+    }
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        eeprom_read_block(const_cast<uint32_t*>(data), buffer, size_u32*sizeof(uint32_t));
+
+        return true;
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        return Program(buffer, data, size_u32, 0, false);
+    }
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        uint32_t *b = const_cast<uint32_t*>(buffer);
+        uint32_t i;
+
+        for(i = 0; i < pages * (PSZ>>2); i++) {
+            eeprom_update_dword(&b[i], 0xffffffffUL);
+        }
+
+        return true;
+    }
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return swimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
+    }
+}; // class EeDword
+
+
+/**
+ * Print a result row
+ */
+static void Report(const char *name, const uint32_t saves) {
+    uint32_t w = 0, a;
+
+    for(a = 0; a <= E2END; a++) {
+        if (g_ee_sim.GetWear(static_cast<uint16_t>(a)) > w) {
+            w = g_ee_sim.GetWear(static_cast<uint16_t>(a));
+        }
+    }
+    std::cout << std::left << std::setw(10) << name << std::right <<
+        std::setw(12) << g_ee_sim.GetWrites() <<
+        std::setw(14) << std::fixed << std::setprecision(2) << static_cast<double>(g_ee_sim.GetWrites()) / saves <<
+        std::setw(12) << g_ee_sim.GetWriteMs() <<
+        std::setw(12) << w <<
+        std::setw(12) << g_ee_sim.GetCalls() << std::endl;
+}
+
+
+/**
+ * Benchmark entry point
+ *
+ * @return int Status
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main() {
+    EeDword<32> ee;
+    cal_t c, d;
+    uint32_t i;
+
+    memset(&c, 0, sizeof(c));
+    c.serial = 0x12345678UL;
+    c.gain = 1000;
+
+    std::cout << "cal_t " << sizeof(cal_t) << " Bytes, " << SAVES << " saves, " << COPIES << " copies" << std::endl;
+    std::cout << std::left << std::setw(10) << "path" << std::right << std::setw(12) << "Bytes" << std::setw(14) <<
+        "Bytes/save" << std::setw(12) << "ms" << std::setw(12) << "max wear" << std::setw(12) << "calls" << std::endl;
+
+    // Struct, wrap::Ee dword path
+    {
+        persist::Struct<cal_t> ps(ee, ee.GetStart(), COPIES);
+
+        g_ee_sim.Reset();
+        for(i = 0; i < SAVES; i++) {
+            c.runs = static_cast<uint16_t>(i);
+            c.offset = static_cast<int16_t>(i & 0x0f);
+            CHECK(ps.Save(c, i == 0));
+        }
+        Report("Struct", SAVES);
+        memset(&d, 0, sizeof(d));
+        CHECK(ps.Load(d) && !memcmp(&c, &d, sizeof(c)));
+    }
+
+    // Parameter ring, Byte update
+    {
+        wrap::EeRing<cal_t, COPIES> ring(0);
+
+        g_ee_sim.Reset();
+        CHECK(!ring.Load(d));
+        for(i = 0; i < SAVES; i++) {
+            c.runs = static_cast<uint16_t>(i);
+            c.offset = static_cast<int16_t>(i & 0x0f);
+            CHECK(ring.Save(c));
+        }
+        Report("EeRing", SAVES);
+
+        // Unchanged parameter is not written
+        i = g_ee_sim.GetWrites();
+        CHECK(ring.Save(c) && g_ee_sim.GetWrites() == i);
+
+        // Fresh instance finds current copy, status count wraps at 0xfe
+        wrap::EeRing<cal_t, COPIES> fresh(0);
+        memset(&d, 0, sizeof(d));
+        CHECK(fresh.Load(d) && !memcmp(&c, &d, sizeof(c)));
+        CHECK(fresh.GetIndex() == ring.GetIndex() && ring.GetIndex() == (SAVES - 1) % COPIES);
+
+        // Interrupted save, parameter written without status, previous copy stays current
+        d = c;
+        d.runs++;
+        eeprom_update_block(&d, reinterpret_cast<uint8_t*>(COPIES + ((SAVES % COPIES) * sizeof(cal_t))), sizeof(d));
+        wrap::EeRing<cal_t, COPIES> cut(0);
+        CHECK(cut.Load(d) && !memcmp(&c, &d, sizeof(c)));
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * \file
+ * Host emulator of AVR on-chip EEPROM and the avr-libc eeprom_* API for testing without hardware.  Byte
+ * writes are counted only where the value changes, as eeprom_update_* does on device, each costing one
+ * 3.4ms erase/write cycle.
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#ifndef EESIM_H
+#define EESIM_H
+
+#include <cstdint>
+#include <cstring>
+
+#if !defined(E2END)
+#define E2END               1023        // ATmega328P
+#endif // !defined(E2END)
+
+
+/**
+ * EEPROM emulator, single instance used by the eeprom_* functions below
+ */
+class EeSim {
+public:
+    EeSim() {
+        Reset();
+    }
+
+    void Reset() {
+        memset(mem_, 0xff, sizeof(mem_));
+        memset(wear_, 0, sizeof(wear_));
+        Clear();
+    }
+
+    /**
+     * Clear counters
+     */
+    void Clear() {
+        writes_ = 0;
+        reads_ = 0;
+        calls_ = 0;
+    }
+
+    uint8_t* GetMemory() {
+        return mem_;
+    }
+
+    /**
+     * Get Bytes written (changed), each one cell erase/write cycle
+     */
+    uint32_t GetWrites() const { return writes_; }
+    uint32_t GetReads() const { return reads_; }
+
+    /**
+     * Get eeprom_* calls
+     */
+    uint32_t GetCalls() const { return calls_; }
+
+    /**
+     * Get write time (ms), 3.4ms per Byte
+     */
+    uint32_t GetWriteMs() const { return (writes_ * 34 + 5) / 10; }
+
+    /**
+     * Get write cycles of one cell
+     */
+    uint32_t GetWear(const uint16_t address) const { return wear_[address]; }
+
+    uint8_t ReadByte(const void *p) {
+        reads_++;
+        return mem_[GetAddress(p)];
+    }
+
+    void UpdateByte(void *p, const uint8_t v) {
+        uint16_t a = GetAddress(p);
+
+        if (mem_[a] != v) {
+            mem_[a] = v;
+            wear_[a]++;
+            writes_++;
+        }
+    }
+
+    void Call() {
+        calls_++;
+    }
+
+protected:
+    static uint16_t GetAddress(const void *p) {
+        return static_cast<uint16_t>(reinterpret_cast<uintptr_t>(p) % (E2END + 1));
+    }
+
+protected:
+    uint8_t     mem_[E2END + 1];
+    uint32_t    wear_[E2END + 1];
+    uint32_t    writes_;
+    uint32_t    reads_;
+    uint32_t    calls_;
+}; // class EeSim
+
+EeSim g_ee_sim;
+
+
+// avr-libc API
+uint8_t eeprom_read_byte(const uint8_t *p) {
+    g_ee_sim.Call();
+    return g_ee_sim.ReadByte(p);
+}
+
+uint32_t eeprom_read_dword(const uint32_t *p) {
+    const uint8_t *b = reinterpret_cast<const uint8_t*>(p);
+    uint32_t v = 0;
+    int i;
+
+    g_ee_sim.Call();
+    for(i = 3; i >= 0; i--) {
+        v = (v << 8) | g_ee_sim.ReadByte(b + i);
+    }
+
+    return v;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+    const uint8_t *s = static_cast<const uint8_t*>(src);
+    uint8_t *d = static_cast<uint8_t*>(dst);
+    size_t i;
+
+    g_ee_sim.Call();
+    for(i = 0; i < n; i++) {
+        d[i] = g_ee_sim.ReadByte(s + i);
+    }
+}
+
+void eeprom_update_byte(uint8_t *p, uint8_t v) {
+    g_ee_sim.Call();
+    g_ee_sim.UpdateByte(p, v);
+}
+
+void eeprom_update_dword(uint32_t *p, uint32_t v) {
+    uint8_t *b = reinterpret_cast<uint8_t*>(p);
+    int i;
+
+    g_ee_sim.Call();
+    for(i = 0; i < 4; i++, v>>= 8) {
+        g_ee_sim.UpdateByte(b + i, static_cast<uint8_t>(v));
+    }
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n) {
+    const uint8_t *s = static_cast<const uint8_t*>(src);
+    uint8_t *d = static_cast<uint8_t*>(dst);
+    size_t i;
+
+    g_ee_sim.Call();
+    for(i = 0; i < n; i++) {
+        g_ee_sim.UpdateByte(d + i, s[i]);
+    }
+}
+
+#endif // EESIM_H
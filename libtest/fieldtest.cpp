@@ -0,0 +1,99 @@
+/**
+ * \file
+ * Test of single field reads, direct through Map on memory mapped media and through Read otherwise.
+ * Build with any C++ compiler, e.g. "g++ -I.. fieldtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    serial;
+    uint8_t     mode;
+    uint16_t    rate;           // Not word aligned in data block
+    uint8_t     table[400];
+    uint8_t     name[7];        // Spans words
+}cfg_t;
+
+
+int main() {
+    FlashSim<1024, 8> sim;
+    cfg_t c, l;
+    uint8_t name[7];
+    uint16_t rate;
+    uint32_t serial, n;
+
+    memset(&c, 0, sizeof(c));
+    c.serial = 1234;
+    c.rate = 0xbeef;
+    memcpy(c.name, "ABCDEFG", sizeof(c.name));
+    {
+        persist::Struct<cfg_t> ps(sim, sim.GetStart(), 4);
+
+        CHECK(ps.Save(c, true));
+        c.serial = 1235;
+        CHECK(ps.Save(c));
+    }
+
+    // Mapped, cold locate reads and CRC checks the whole data block once, fields then without any read
+    {
+        persist::Struct<cfg_t> ps(sim, sim.GetStart(), 4);
+        const uint16_t *p;
+
+        sim.Clear();
+        p = ps.GetField(&cfg_t::rate);
+        CHECK(p && *p == 0xbeef);
+        n = sim.GetReadWords();
+        CHECK(n >= persist::Struct<cfg_t>::GetStorageUnitSize() / sizeof(uint32_t));
+        CHECK(ps.ReadField(&cfg_t::serial, serial) && serial == 1235);
+        CHECK(ps.ReadField(&cfg_t::name, name) && !memcmp(name, "ABCDEFG", sizeof(name)));
+        CHECK(sim.GetReadWords() == n);
+    }
+
+    // Not mapped, no pointer, each field read only covers the member's words
+    sim.SetMapped(false);
+    {
+        persist::Struct<cfg_t> ps(sim, sim.GetStart(), 4);
+
+        CHECK(!ps.GetField(&cfg_t::rate));
+        sim.Clear();
+        CHECK(ps.ReadField(&cfg_t::rate, rate) && rate == 0xbeef);
+        CHECK(sim.GetReads() == 1 && sim.GetReadWords() == 1);
+        sim.Clear();
+        CHECK(ps.ReadField(&cfg_t::name, name) && !memcmp(name, "ABCDEFG", sizeof(name)));
+        CHECK(sim.GetReadWords() <= 3);
+
+        // Same value as a full load, and new value after save
+        CHECK(ps.Load(l) && l.serial == 1235 && l.rate == 0xbeef);
+        c.rate = 7;
+        CHECK(ps.Save(c));
+        CHECK(ps.ReadField(&cfg_t::rate, rate) && rate == 7);
+    }
+
+    // Nothing valid on media, no field
+    memset(sim.GetMemory(), 0xff, sim.GetSize());
+    {
+        persist::Struct<cfg_t> ps(sim, sim.GetStart(), 4);
+
+        CHECK(!ps.ReadField(&cfg_t::rate, rate));
+        sim.SetMapped(true);
+        CHECK(!ps.GetField(&cfg_t::rate));
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,216 @@
+/**
+ * \file
+ * Host emulator of on-chip NOR flash as a persist::Media, for testing storage classes without hardware.
+ * Writes only clear bits, erase sets a page to 0xff.  Media accesses are counted and a power cut or
+ * failed operations can be injected: after a cut the interrupted write is left half done and every
+ * later write or erase fails until \ref FlashSim::Restore (power up).
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#ifndef FLASHSIM_H
+#define FLASHSIM_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "../sw/crc.h"
+
+
+/**
+ * NOR flash emulator, locations are CPU addresses of emulator memory
+ *
+ * \tparam PSZ page (erase unit) size, Bytes
+ * \tparam PAGES page count
+ */
+template<uint32_t PSZ, uint32_t PAGES>
+class FlashSim : public persist::Media, protected swimp::Crc {
+public:
+    FlashSim() : mapped_(true), cut_(-1), fail_(0), fail_at_(-1), down_(false), partial_(false) {
+        memset(mem_, 0xff, sizeof(mem_));
+        Clear();
+    }
+
+    /**
+     * Clear counters
+     */
+    void Clear() {
+        reads_ = read_words_ = writes_ = erases_ = 0;
+    }
+
+    uint8_t* GetMemory() {
+        return reinterpret_cast<uint8_t*>(mem_);
+    }
+
+    uint32_t GetReads() const { return reads_; }
+    uint32_t GetReadWords() const { return read_words_; }
+    uint32_t GetWrites() const { return writes_; }
+    uint32_t GetErases() const { return erases_; }
+
+    /**
+     * Set memory mapped, \ref Map returns CPU addresses when true (default)
+     */
+    void SetMapped(const bool mapped) {
+        mapped_ = mapped;
+    }
+
+    /**
+     * Cut power after n more writes or erases succeed.  The next one is left half done and fails, as
+     * does every one after until \ref Restore
+     */
+    void CutAfter(const int32_t n) {
+        cut_ = n;
+    }
+
+    /**
+     * Fail next n writes or erases without changing memory (worn or write protected cells)
+     */
+    void FailNext(const uint32_t n) {
+        fail_ = n;
+    }
+
+    /**
+     * Fail one write or erase after n more succeed, without changing memory
+     */
+    void FailAfter(const int32_t n) {
+        fail_at_ = n;
+    }
+
+    /**
+     * Power up after a cut, no failures pending
+     */
+    void Restore() {
+        cut_ = -1;
+        fail_ = 0;
+        fail_at_ = -1;
+        down_ = partial_ = false;
+    }
+
+    uint32_t GetPageSize() const {
+        return PSZ;
+    }
+
+    uint32_t GetSize() const {
+        return PSZ * PAGES;
+    }
+
+    uint32_t* const GetStart() const {
+        return const_cast<uint32_t*>(mem_);
+    }
+
+    uint32_t* const GetEnd() const {
+        return GetStart() + ((PSZ * PAGES)>>2);
+    }
+
+    bool Program(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32,
+                            const uint32_t page_size_u32, const bool use_lock) {
+        uint32_t first, last;
+        bool done = InRange(buffer, size_u32) && size_u32 > 0;
+
+        (void)page_size_u32;
+        (void)use_lock;
+
+        // Erase pages covered then write, unless already holding data
+        if (done && memcmp(buffer, data, static_cast<uint32_t>(size_u32)<<2)) {
+            first = static_cast<uint32_t>((buffer - mem_) * sizeof(uint32_t)) / PSZ;
+            last = static_cast<uint32_t>((buffer + size_u32 - 1 - mem_) * sizeof(uint32_t)) / PSZ;
+            done = Erase(mem_ + first * (PSZ>>2), last - first + 1) && Write(buffer, data, size_u32) && \
+                    !memcmp(buffer, data, static_cast<uint32_t>(size_u32)<<2);
+        }
+
+        return done;
+    }
+
+    bool Read(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        bool ok = InRange(buffer, size_u32);
+
+        if (ok) {
+            memcpy(const_cast<uint32_t*>(data), buffer, static_cast<uint32_t>(size_u32)<<2);
+            reads_++;
+            read_words_+= static_cast<uint32_t>(size_u32);
+        }
+
+        return ok;
+    }
+
+    uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
+        return swimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
+    }
+
+    const uint32_t* Map(const uint32_t *buffer) const {
+        return mapped_ ? buffer : NULL;
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        uint32_t *d = const_cast<uint32_t*>(buffer), n = static_cast<uint32_t>(size_u32), i;
+        bool done = InRange(buffer, size_u32) && Operate();
+
+        // Half done when power cut
+        if (done || partial_) {
+            for(i = 0; i < (done ? n : n / 2); i++) {
+                d[i]&= data[i];
+            }
+            writes_++;
+        }
+        partial_ = false;
+
+        return done;
+    }
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        uint32_t o = static_cast<uint32_t>((buffer - mem_) * sizeof(uint32_t));
+        bool done = InRange(buffer, static_cast<int16_t>(0)) && !(o % PSZ) && o + pages * PSZ <= PSZ * PAGES && Operate();
+
+        if (done) {
+            memset(const_cast<uint32_t*>(buffer), 0xff, pages * PSZ);
+            erases_++;
+        }
+        partial_ = false;
+
+        return done;
+    }
+
+protected:
+    bool InRange(const uint32_t *buffer, const int16_t size_u32) const {
+        return size_u32 >= 0 && buffer >= mem_ && buffer + size_u32 <= mem_ + ((PSZ * PAGES)>>2);
+    }
+
+    /**
+     * Count a write or erase against injected failures
+     *
+     * \retval true go ahead
+     * \retval false failed, partial_ set when this is the cut
+     */
+    bool Operate() {
+        bool ok = !down_ && !fail_ && fail_at_ != 0;
+
+        if (fail_at_ >= 0) {
+            fail_at_--;
+        }
+        if (fail_) {
+            fail_--;
+        }else if (ok && cut_ == 0) {
+            down_ = partial_ = true;
+            ok = false;
+        }else if (ok && cut_ > 0) {
+            cut_--;
+        }
+
+        return ok;
+    }
+
+protected:
+    uint32_t    mem_[(PSZ * PAGES)>>2];
+    bool        mapped_;
+    int32_t     cut_;               // Writes or erases until cut, -1 none
+    uint32_t    fail_;
+    int32_t     fail_at_;           // Writes or erases until single failure, -1 none
+    bool        down_;              // Power cut
+    bool        partial_;           // Operation being cut
+    uint32_t    reads_;
+    uint32_t    read_words_;
+    uint32_t    writes_;
+    uint32_t    erases_;
+}; // class FlashSim
+
+#endif // FLASHSIM_H
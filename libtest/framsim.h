@@ -0,0 +1,131 @@
+/**
+ * \file
+ * Host emulator of a SPI FRAM device (MB85RS class) for testing wrap::SpiFram without hardware.
+ * Bytes are written directly, no erase and no busy time.  A write needs write enable, which a
+ * completed write clears.  Write protect and an absent device (reads all 1s) can be set to check
+ * failures are reported, SPI gives no acknowledge.
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#ifndef FRAMSIM_H
+#define FRAMSIM_H
+
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ * SPI FRAM emulator, use \ref Transfer as wrap::SpiFram transfer function with emulator as context
+ *
+ * \tparam SIZE device size (Bytes), power of 2.  Above 64KB 3 address Bytes
+ */
+template<uint32_t SIZE>
+class FramSim {
+public:
+    FramSim() : wel_(false), protected_(false), absent_(false), writes_(0), written_(0), reads_(0), violations_(0) {
+        memset(mem_, 0, sizeof(mem_));
+    }
+
+    /**
+     * SPI transfer, see wrap::SpiFram::tTransfer
+     */
+    static bool Transfer(void *context, const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx,
+                            uint8_t *rx, const uint16_t size) {
+        return static_cast<FramSim*>(context)->Command(cmd, cmd_size, tx, rx, size);
+    }
+
+    uint8_t* GetMemory() { return mem_; }
+    uint32_t GetWrites() const { return writes_; }
+    uint32_t GetWritten() const { return written_; }
+    uint32_t GetReads() const { return reads_; }
+
+    /**
+     * Get count of commands with wrong address Bytes or writes not enabled (not write protect)
+     */
+    uint32_t GetViolations() const { return violations_; }
+
+    /**
+     * Set write protected (WP pin, block protect bits), writes ignored
+     */
+    void SetProtected(const bool on) {
+        protected_ = on;
+    }
+
+    /**
+     * Set device absent or dead, commands ignored and reads all 1s
+     */
+    void SetAbsent(const bool on) {
+        absent_ = on;
+    }
+
+protected:
+    bool Command(const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+        uint8_t address_size = (SIZE > 0x10000UL) ? 3 : 2;
+        uint32_t a = 0, i;
+
+        if (absent_) {
+            if (rx) {
+                memset(rx, 0xff, size);
+            }
+            return true;
+        }
+        if (cmd[0] != 0x06 && cmd[0] != 0x04 && cmd_size != 1 + address_size) {
+            violations_++;
+            return true;
+        }
+        for(i = 1; i < cmd_size; i++) {
+            a = (a << 8) | cmd[i];
+        }
+
+        switch(cmd[0]) {
+        case 0x06:
+            wel_ = true;
+            break;
+
+        case 0x04:
+            wel_ = false;
+            break;
+
+        case 0x03:    // Read, wraps at device end
+            for(i = 0; i < size; i++) {
+                rx[i] = mem_[(a + i) % SIZE];
+            }
+            reads_++;
+            break;
+
+        case 0x02:    // Write, wraps at device end
+            if (!wel_) {
+                violations_++;
+                break;
+            }
+            if (!protected_) {
+                for(i = 0; i < size; i++) {
+                    mem_[(a + i) % SIZE] = tx[i];
+                }
+                written_+= size;
+            }
+            writes_++;
+            wel_ = false;
+            break;
+
+        default:
+            violations_++;
+            break;
+        }
+
+        return true;
+    }
+
+protected:
+    uint8_t     mem_[SIZE];
+    bool        wel_;
+    bool        protected_;
+    bool        absent_;
+    uint32_t    writes_;
+    uint32_t    written_;
+    uint32_t    reads_;
+    uint32_t    violations_;
+}; // class FramSim
+
+#endif // FRAMSIM_H
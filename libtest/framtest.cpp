@@ -0,0 +1,124 @@
+/**
+ * \file
+ * Test of SPI FRAM media wrapper against host emulator, no hardware.  Build with any C++ compiler,
+ * e.g. "g++ -I.. framtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../ext/spifram.h"
+#include "../struct.h"
+#include "framsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    serial;
+    uint32_t    count;
+    uint8_t     name[100];
+}cfg_t;
+
+FramSim<32768> g_sim;               // MB85RS256
+FramSim<131072> g_sim_large;        // MB85RS1MT, 3 address Bytes
+uint32_t g_large_read[20000];       // Above 0xffff Bytes
+
+
+int main() {
+    wrap::SpiFram<64> fram(FramSim<32768>::Transfer, &g_sim, 32768);
+    wrap::SpiFram<64> fram_large(FramSim<131072>::Transfer, &g_sim_large, 131072);
+    uint32_t b[40], r[40], i, w;
+
+    // Write, read back
+    for(i = 0; i < 40; i++) {
+        b[i] = i * 0x01020304UL;
+    }
+    CHECK(fram.Write(fram.GetStart() + 10, b, 40));
+    CHECK(fram.Read(fram.GetStart() + 10, r, 40) && !memcmp(b, r, sizeof(b)));
+    CHECK(fram_large.Write(fram_large.GetStart() + 20000, b, 40));
+    CHECK(!memcmp(g_sim_large.GetMemory() + 80000, b, sizeof(b)));
+
+    // Read above 16bit transfer size is split
+    for(i = 0; i < 80000; i++) {
+        g_sim_large.GetMemory()[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+    }
+    CHECK(fram_large.Read(fram_large.GetStart(), g_large_read, 20000));
+    CHECK(!memcmp(g_sim_large.GetMemory(), g_large_read, sizeof(g_large_read)));
+
+    // Unchanged Bytes skipped, only span of one changed Byte written
+    w = g_sim.GetWritten();
+    b[20]^= 0x00ff0000UL;
+    CHECK(fram.Write(fram.GetStart() + 10, b, 40));
+    CHECK(g_sim.GetWritten() - w == 1);
+    w = g_sim.GetWritten();
+    CHECK(fram.Write(fram.GetStart() + 10, b, 40));
+    CHECK(g_sim.GetWritten() == w);
+
+    // Erase in chunks to erase state
+    CHECK(fram.Erase(fram.GetStart(), 2));
+    for(i = 0; i < 128; i++) {
+        CHECK(g_sim.GetMemory()[i] == 0xff);
+    }
+    CHECK(g_sim.GetMemory()[128] == reinterpret_cast<uint8_t*>(b)[88]);
+
+    // Persistent structure, two slots alternately
+    {
+        persist::Struct<cfg_t> ps(fram, fram.GetStart() + 256, 4);
+        cfg_t c;
+
+        memset(&c, 0, sizeof(c));
+        memcpy(c.name, "FRAM", 4);
+        CHECK(!ps.Load(c));
+        CHECK(ps.Save(c, true));
+        for(i = 1; i <= 20; i++) {
+            c.count = i;
+            w = g_sim.GetWritten();
+            CHECK(ps.Save(c));
+            CHECK(g_sim.GetWritten() - w < 32);     // Header and count span of 116 Byte data block
+        }
+    }
+    {
+        persist::Struct<cfg_t> ps(fram, fram.GetStart() + 256, 4);
+        cfg_t c;
+
+        CHECK(ps.Load(c) && c.count == 20 && !memcmp(c.name, "FRAM", 4));
+    }
+
+    // Write protected or absent device, writes fail and the copy saved before still loads
+    for(i = 0; i < 2; i++) {
+        persist::Struct<cfg_t> ps(fram, fram.GetStart() + 256, 4);
+        cfg_t c;
+
+        CHECK(ps.Load(c));
+        c.count = 100;
+        if (i == 0) {
+            g_sim.SetProtected(true);
+            CHECK(!fram.Write(fram.GetStart() + 10, r, 40));
+            CHECK(!fram.Erase(fram.GetStart() + (128>>2), 1));
+            CHECK(!ps.Save(c));
+            g_sim.SetProtected(false);
+        }else {
+            g_sim.SetAbsent(true);
+            CHECK(!ps.Save(c));
+            g_sim.SetAbsent(false);
+        }
+
+        persist::Struct<cfg_t> again(fram, fram.GetStart() + 256, 4);
+
+        CHECK(again.Load(c) && c.count == 20);
+    }
+
+    CHECK(!g_sim.GetViolations() && !g_sim_large.GetViolations());
+    std::cout << "writes      = " << g_sim.GetWrites() << ", " << g_sim.GetWritten() << " Bytes" << std::endl;
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,146 @@
+/**
+ * \file
+ * Test of commit group, power cut at every point of a commit including between member saves and the
+ * commit record save, rollback of staged members to the committed copies and commit cost.
+ * Build with any C++ compiler, e.g. "g++ -I.. grouptest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "../group.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    address;
+    uint16_t    port;
+}net_t;
+
+typedef struct {
+    uint8_t     key[16];
+    uint32_t    address;        // Must match net_t
+}cred_t;
+
+FlashSim<128, 12> g_sim;
+uint8_t g_image[128 * 12];
+
+// Member and commit record storage, 4 pages each
+#define NET_START       (g_sim.GetStart())
+#define CRED_START      (g_sim.GetStart() + (4 * 128 / sizeof(uint32_t)))
+#define COMMIT_START    (g_sim.GetStart() + (8 * 128 / sizeof(uint32_t)))
+
+
+/**
+ * Load group and both members through it
+ *
+ * \return true loaded and consistent
+ */
+static bool LoadAll(net_t &net, cred_t &cred) {
+    persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+    persist::Struct<cred_t> cred_ps(g_sim, CRED_START, 4);
+    persist::Group<2> grp(g_sim, COMMIT_START, 4);
+
+    return grp.Load() && grp.Load(0, net_ps, net) && grp.Load(1, cred_ps, cred) && net.address == cred.address;
+}
+
+
+int main() {
+    uint32_t n, address;
+    bool done;
+    net_t net;
+    cred_t cred;
+
+    memset(&net, 0, sizeof(net));
+    memset(&cred, 0, sizeof(cred));
+    net.address = cred.address = 1;
+    {
+        persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+        persist::Struct<cred_t> cred_ps(g_sim, CRED_START, 4);
+        persist::Group<2> grp(g_sim, COMMIT_START, 4);
+
+        CHECK(!grp.Load());
+        CHECK(grp.Stage(0, net_ps, net) && grp.Stage(1, cred_ps, cred));
+        CHECK(!grp.Stage(0, net_ps, net));
+        CHECK(grp.Commit());
+    }
+    CHECK(LoadAll(net, cred) && net.address == 1);
+
+    // Commit costs N+1 saves, one erase each
+    g_sim.Clear();
+    {
+        persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+        persist::Struct<cred_t> cred_ps(g_sim, CRED_START, 4);
+        persist::Group<2> grp(g_sim, COMMIT_START, 4);
+
+        CHECK(grp.Load() && grp.Load(0, net_ps, net) && grp.Load(1, cred_ps, cred));
+        net.address = cred.address = 2;
+        CHECK(grp.Stage(0, net_ps, net) && grp.Stage(1, cred_ps, cred) && grp.Commit());
+    }
+    CHECK(g_sim.GetErases() == 3);
+    CHECK(LoadAll(net, cred) && net.address == 2);
+
+    // Members staged, power lost before commit.  Newest member copies ignored, committed ones loaded
+    {
+        persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+        persist::Struct<cred_t> cred_ps(g_sim, CRED_START, 4);
+        persist::Group<2> grp(g_sim, COMMIT_START, 4);
+
+        CHECK(grp.Load() && grp.Load(0, net_ps, net) && grp.Load(1, cred_ps, cred));
+        net.address = cred.address = 3;
+        CHECK(grp.Stage(0, net_ps, net) && grp.Stage(1, cred_ps, cred));
+    }
+    {
+        persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+
+        CHECK(net_ps.Load(net) && net.address == 3);
+    }
+    CHECK(LoadAll(net, cred) && net.address == 2);
+
+    // Staging again after rollback, committed copy kept while written
+    for(address = 4; address < 12; address++) {
+        persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+        persist::Struct<cred_t> cred_ps(g_sim, CRED_START, 4);
+        persist::Group<2> grp(g_sim, COMMIT_START, 4);
+
+        CHECK(grp.Load() && grp.Load(0, net_ps, net) && grp.Load(1, cred_ps, cred) && net.address == 2);
+        net.address = cred.address = address;
+        CHECK(grp.Stage(0, net_ps, net) && grp.Stage(1, cred_ps, cred));
+    }
+    CHECK(LoadAll(net, cred) && net.address == 2);
+
+    // Power cut after each write or erase of a commit, both old or both new
+    memcpy(g_image, g_sim.GetMemory(), sizeof(g_image));
+    for(n = 0, done = false; !done; n++) {
+        memcpy(g_sim.GetMemory(), g_image, sizeof(g_image));
+        {
+            persist::Struct<net_t> net_ps(g_sim, NET_START, 4);
+            persist::Struct<cred_t> cred_ps(g_sim, CRED_START, 4);
+            persist::Group<2> grp(g_sim, COMMIT_START, 4);
+
+            CHECK(grp.Load() && grp.Load(0, net_ps, net) && grp.Load(1, cred_ps, cred));
+            net.address = cred.address = 20;
+            g_sim.CutAfter(static_cast<int32_t>(n));
+            done = grp.Stage(0, net_ps, net) && grp.Stage(1, cred_ps, cred) && grp.Commit();
+            g_sim.Restore();
+        }
+        CHECK(LoadAll(net, cred));
+        CHECK(net.address == 2 || net.address == 20);
+        CHECK(!done || net.address == 20);
+    }
+    std::cout << "cut points  = " << n << std::endl;
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,152 @@
+/**
+ * \file
+ * Test of slot hint, cold load from the hinted slot and its neighbours and fall back to a scan when the
+ * hint is stale or corrupted.  Uses the RAM hint store as host simulated backend.
+ * Build with any C++ compiler, e.g. "g++ -I.. hinttest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "../hint.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    value;
+    uint8_t     name[20];
+}cfg_t;
+
+typedef persist::Struct<cfg_t> ps_t;
+
+FlashSim<64, 8> g_sim;          // One page per slot
+
+
+int main() {
+    persist::RamHint hint;
+    uint32_t i, scan;
+    uint16_t slot;
+    cfg_t c, l;
+
+    memset(&c, 0, sizeof(c));
+
+    // Hint recorded on every save
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachHint(&hint);
+        CHECK(!ps.Load(l) && hint.GetSets() == 0);
+        for(i = 1; i <= 5; i++) {
+            c.value = i;
+            CHECK(ps.Save(c, i == 1));
+            CHECK(hint.GetSets() == i && hint.Get(slot) && slot == i - 1);
+        }
+    }
+
+    // Scan without hint
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5);
+        scan = g_sim.GetReads();
+        CHECK(scan > 3);
+    }
+
+    // Hinted, slot header, following header and data block only
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachHint(&hint);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5 && ps.GetCounter() == 4);
+        CHECK(g_sim.GetReads() == 3 && hint.GetSets() == 5);
+    }
+
+    // Stale by one save, following neighbour taken without scan
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        hint.Set(3);
+        ps.AttachHint(&hint);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5);
+        CHECK(g_sim.GetReads() == 5);
+    }
+
+    // Stale by more than the neighbours followed, scan and hint recorded again
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        hint.Set(0);
+        ps.AttachHint(&hint);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5);
+        CHECK(g_sim.GetReads() > scan && hint.Get(slot) && slot == 4);
+    }
+
+    // Corrupted, out of range or pointing at erased slot, scan
+    for(i = 0; i < 3; i++) {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        if (i == 0) {
+            hint.Set(1000);
+        }else if (i == 1) {
+            hint.Set(6);
+        }else {
+            hint.Invalidate();
+        }
+        ps.AttachHint(&hint);
+        CHECK(ps.Load(l) && l.value == 5 && ps.GetCounter() == 4);
+        CHECK(hint.Get(slot) && slot == 4);
+    }
+
+    // Hint stale by a ring, save into hinted slot cut with header written.  Copy before taken without scan
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        CHECK(ps.Load(l));
+        for(i = 6; i < 13; i++) {
+            c.value = i;
+            CHECK(ps.Save(c));
+        }
+        c.value = 13;
+        g_sim.CutAfter(1);
+        CHECK(!ps.Save(c));
+        g_sim.Restore();
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachHint(&hint);
+        CHECK(hint.Get(slot) && slot == 4);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 12 && ps.GetCounter() == 11);
+        CHECK(g_sim.GetReads() == 4);
+    }
+
+    // Same, cut before header written.  Previous neighbour taken without scan
+    CHECK(g_sim.Erase(g_sim.GetStart() + 4 * (64>>2), 1));
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachHint(&hint);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 12 && ps.GetCounter() == 11);
+        CHECK(g_sim.GetReads() == 5);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
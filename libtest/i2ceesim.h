@@ -0,0 +1,104 @@
+/**
+ * \file
+ * Host emulator of an I2C EEPROM device (24LCxx class) for testing wrap::I2cEe without hardware.
+ * Page writes wrap within their write page as real devices do and the device doesn't acknowledge
+ * for a few transactions after each write (internal write cycle).
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#ifndef I2CEESIM_H
+#define I2CEESIM_H
+
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ * I2C EEPROM emulator, use \ref Transfer as wrap::I2cEe transfer function with emulator as context
+ *
+ * \tparam SIZE device size (Bytes)
+ * \tparam PAGE write page size (Bytes)
+ */
+template<uint32_t SIZE, uint16_t PAGE>
+class I2cEeSim {
+public:
+    I2cEeSim(const uint8_t device=0x50) : device_(device), busy_(0), writes_(0), written_(0), polls_(0), violations_(0) {
+        memset(mem_, 0xff, sizeof(mem_));
+    }
+
+    /**
+     * I2C transfer, see wrap::I2cEe::tTransfer
+     */
+    static bool Transfer(void *context, const uint8_t device, const uint8_t *address, const uint8_t address_size,
+                            const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+        return static_cast<I2cEeSim*>(context)->Transaction(device, address, address_size, tx, rx, size);
+    }
+
+    uint8_t* GetMemory() { return mem_; }
+    uint32_t GetWrites() const { return writes_; }
+    uint32_t GetWritten() const { return written_; }
+    uint32_t GetPolls() const { return polls_; }
+
+    /**
+     * Get count of transactions addressing wrong device or writes crossing a write page
+     */
+    uint32_t GetViolations() const { return violations_; }
+
+protected:
+    bool Transaction(const uint8_t device, const uint8_t *address, const uint8_t address_size, const uint8_t *tx,
+                        uint8_t *rx, const uint16_t size) {
+        uint32_t a = 0, i;
+        bool small = SIZE <= 2048;
+
+        if (!address_size) {
+            polls_++;
+        }
+        // Busy with internal write cycle, NACK
+        if (busy_) {
+            busy_--;
+            return false;
+        }
+        if ((device & (small ? 0x78 : 0x7f)) != device_) {
+            violations_++;
+            return false;
+        }
+        for(i = 0; i < address_size; i++) {
+            a = (a << 8) | address[i];
+        }
+        if (small) {
+            a|= static_cast<uint32_t>(device & 0x07) << 8;
+        }
+        a%= SIZE;
+
+        if (tx && size) {
+            if ((a % PAGE) + size > PAGE) {
+                violations_++;
+            }
+            for(i = 0; i < size; i++) {
+                mem_[(a - (a % PAGE)) + ((a + i) % PAGE)] = tx[i];
+            }
+            writes_++;
+            written_+= size;
+            busy_ = 4;
+        }else if (rx) {
+            // Sequential read wraps at device end
+            for(i = 0; i < size; i++) {
+                rx[i] = mem_[(a + i) % SIZE];
+            }
+        }
+
+        return true;
+    }
+
+protected:
+    uint8_t     mem_[SIZE];
+    uint8_t     device_;
+    uint32_t    busy_;
+    uint32_t    writes_;
+    uint32_t    written_;
+    uint32_t    polls_;
+    uint32_t    violations_;
+}; // class I2cEeSim
+
+#endif // I2CEESIM_H
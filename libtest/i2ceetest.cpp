@@ -0,0 +1,103 @@
+/**
+ * \file
+ * Test of I2C EEPROM media wrapper against host emulator, no hardware.  Build with any C++ compiler,
+ * e.g. "g++ -I.. i2ceetest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../ext/i2cee.h"
+#include "../struct.h"
+#include "i2ceesim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    serial;
+    uint16_t    rate;
+    uint8_t     name[90];
+}cfg_t;
+
+I2cEeSim<32768, 64> g_sim;          // 24LC256
+I2cEeSim<2048, 16> g_sim_small;     // 24LC16, block bits in device address
+
+
+int main() {
+    wrap::I2cEe ee(I2cEeSim<32768, 64>::Transfer, &g_sim, 0x50, 32768, 64);
+    wrap::I2cEe ee_small(I2cEeSim<2048, 16>::Transfer, &g_sim_small, 0x50, 2048, 16);
+    uint32_t b[40], r[40], i, w;
+
+    // Page split and ACK polling
+    for(i = 0; i < 40; i++) {
+        b[i] = i * 0x01020304UL;
+    }
+    CHECK(ee.Program(ee.GetStart() + 10, b, 40, 0, false));
+    CHECK(ee.Read(ee.GetStart() + 10, r, 40) && !memcmp(b, r, sizeof(b)));
+    CHECK(g_sim.GetWrites() == 4 && g_sim.GetPolls() > 0 && !g_sim.GetViolations());
+
+    // Unchanged Bytes skipped, only span of one changed word written
+    w = g_sim.GetWritten();
+    b[20]^= 0x00ff0000UL;
+    CHECK(ee.Program(ee.GetStart() + 10, b, 40, 0, false));
+    CHECK(g_sim.GetWritten() - w == 1);
+    w = g_sim.GetWritten();
+    CHECK(ee.Program(ee.GetStart() + 10, b, 40, 0, false));
+    CHECK(g_sim.GetWritten() == w);
+
+    // 1 address Byte device across 256 Byte blocks
+    CHECK(ee_small.Program(ee_small.GetStart() + 60, b, 40, 0, false));
+    CHECK(ee_small.Read(ee_small.GetStart() + 60, r, 40) && !memcmp(b, r, sizeof(b)));
+    CHECK(!memcmp(g_sim_small.GetMemory() + 240, b, sizeof(b)) && !g_sim_small.GetViolations());
+
+    // Persistent structure
+    {
+        persist::Struct<cfg_t> ps(ee, ee.GetStart() + 256, 4);
+        cfg_t c;
+
+        memset(&c, 0, sizeof(c));
+        CHECK(!ps.Load(c));
+        CHECK(ps.Save(c, true));
+        for(i = 1; i <= 20; i++) {
+            c.serial = i;
+            CHECK(ps.Save(c));
+        }
+    }
+    {
+        persist::Struct<cfg_t> ps(ee, ee.GetStart() + 256, 4);
+        cfg_t c;
+
+        CHECK(ps.Load(c) && c.serial == 20 && ps.GetCounter() == 20);
+    }
+
+    // Write page outside 8 to 128 or not a power of 2 rounded down, page split still within device pages
+    {
+        wrap::I2cEe odd(I2cEeSim<32768, 64>::Transfer, &g_sim, 0x50, 32768, 100);
+        wrap::I2cEe none(I2cEeSim<32768, 64>::Transfer, &g_sim, 0x50, 32768, 0);
+        wrap::I2cEe big(I2cEeSim<32768, 64>::Transfer, &g_sim, 0x50, 32768, 1000);
+
+        CHECK(odd.GetPageSize() == 64 && none.GetPageSize() == 8 && big.GetPageSize() == 128);
+        for(i = 0; i < 40; i++) {
+            b[i] = ~b[i];
+        }
+        CHECK(odd.Program(odd.GetStart() + 100, b, 40, 0, false));
+        CHECK(none.Program(none.GetStart() + 200, b, 40, 0, false));
+        CHECK(odd.Read(odd.GetStart() + 100, r, 40) && !memcmp(b, r, sizeof(b)));
+        CHECK(none.Read(none.GetStart() + 200, r, 40) && !memcmp(b, r, sizeof(b)));
+    }
+
+    CHECK(!g_sim.GetViolations());
+    std::cout << "writes      = " << g_sim.GetWrites() << ", " << g_sim.GetWritten() << " Bytes" << std::endl;
+    std::cout << "ack polls   = " << g_sim.GetPolls() << std::endl;
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
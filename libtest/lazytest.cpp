@@ -0,0 +1,114 @@
+/**
+ * \file
+ * Test of pointer mode repeated and lazy loads.  A repeat load reads only the header on media unless
+ * the data block changed, a lazy load defers reading the data block to the first access and still tells
+ * when storage needs initialising.  Build with any C++ compiler, e.g. "g++ -I.. lazytest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+// Internal data block accessed through pointer
+#define PERSISTSTRUCT_POINTERS
+
+#include "../media.h"
+#include "../struct.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    value;
+    uint8_t     name[20];
+}cfg_t;
+
+typedef persist::Struct<cfg_t> ps_t;
+
+#define HEAD_U32        (sizeof(persist::HeadStd::tHead) / sizeof(uint32_t))
+
+FlashSim<64, 8> g_sim;
+
+
+int main() {
+    uint32_t i;
+
+    // First boot idiom in lazy mode, storage initialised
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.SetLazy(true);
+        g_sim.Clear();
+        CHECK(!ps.Load() && !ps.IsLoaded());
+        CHECK(g_sim.GetReadWords() == 8 * HEAD_U32);
+        ps.Get()->value = 1;
+        memcpy(ps.Get()->name, "FIRST", 5);
+        CHECK(ps.Save(true) && ps.IsLoaded());
+    }
+
+    // Lazy load, headers only until first access
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.SetLazy(true);
+        g_sim.Clear();
+        CHECK(ps.Load());
+        CHECK(g_sim.GetReads() == 1 && g_sim.GetReadWords() == HEAD_U32);
+        CHECK(ps.Get()->value == 1 && !memcmp(ps.Get()->name, "FIRST", 5));
+        CHECK(ps.IsLoaded());
+
+        // Repeat lazy load, nothing until access, then header compare only
+        g_sim.Clear();
+        CHECK(ps.Load() && g_sim.GetReads() == 0);
+        CHECK(ps.Get()->value == 1 && g_sim.GetReads() == 1 && g_sim.GetReadWords() == HEAD_U32);
+    }
+
+    // Repeat load reads header only
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8), other(g_sim, g_sim.GetStart(), 8);
+
+        CHECK(ps.Load());
+        for(i = 0; i < 3; i++) {
+            g_sim.Clear();
+            CHECK(ps.Load() && ps.Get()->value == 1);
+            CHECK(g_sim.GetReads() == 1 && g_sim.GetReadWords() == HEAD_U32);
+        }
+
+        // Changed in RAM without save, CRC differs so data block read again
+        ps.Get()->value = 99;
+        g_sim.Clear();
+        CHECK(ps.Load() && ps.Get()->value == 1 && g_sim.GetReads() == 2);
+
+        // Slot rewritten by a ring of saves elsewhere, header differs so data block read again
+        CHECK(other.Load());
+        for(i = 2; i < 10; i++) {
+            other.Get()->value = i;
+            CHECK(other.Save());
+        }
+        g_sim.Clear();
+        CHECK(ps.Load() && ps.Get()->value == 9 && ps.GetCounter() == other.GetCounter() && g_sim.GetReads() == 2);
+    }
+
+    // Every data block failing CRC.  Lazy load finds a header, deferred load tells not loaded
+    for(i = 0; i < 8; i++) {
+        g_sim.GetMemory()[i * 64 + 3 * sizeof(uint32_t)]^= 1;
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.SetLazy(true);
+        CHECK(ps.Load() && !ps.IsLoaded());
+        ps.SetLazy(false);
+        CHECK(!ps.Load());
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
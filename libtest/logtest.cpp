@@ -0,0 +1,165 @@
+/**
+ * \file
+ * Test of append only log, page ring wrap, write position found after reboot and failed or cut appends
+ * keeping the write position search valid.  Build with any C++ compiler, e.g. "g++ -I.. logtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../log.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    seq;
+    uint32_t    v[3];
+}sample_t;
+
+typedef persist::Log<sample_t> log_t;
+
+FlashSim<256, 4> g_sim;
+
+
+/**
+ * Check entries retained are in sequence, none damaged
+ *
+ * \return Newest sequence, 0 on failure
+ */
+static uint32_t Walk(log_t &log, const uint32_t count) {
+    sample_t s;
+    uint32_t n = 0, last = 0;
+    bool ok = true;
+
+    for(log_t::Iterator it(log); ok && it.IsValid(); it.Next(), n++) {
+        ok = it.Get(s) && (!n || s.seq == last + 1) && s.v[2] == s.seq * 3;
+        last = s.seq;
+    }
+
+    return (ok && n == count) ? last : 0;
+}
+
+
+int main() {
+    sample_t s;
+    uint32_t i, n, seq = 0, damaged, count;
+    bool done;
+
+    memset(&s, 0, sizeof(s));
+    {
+        log_t log(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(log.Load() && log.GetCount() == 0 && log.GetEntriesPerPage() == 12);
+        for(i = 0; i < 30; i++) {
+            s.seq = ++seq;
+            s.v[2] = s.seq * 3;
+            CHECK(log.Append(s));
+        }
+        CHECK(log.GetCount() == 30 && Walk(log, 30) == 30);
+    }
+
+    // Reboot, write position mid page
+    {
+        log_t log(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(log.Load() && log.GetCount() == 30 && Walk(log, 30) == 30);
+
+        // Wrap, oldest page reclaimed
+        for(i = 0; i < 30; i++) {
+            s.seq = ++seq;
+            s.v[2] = s.seq * 3;
+            CHECK(log.Append(s));
+        }
+        CHECK(log.GetCount() == 48 && Walk(log, 48) == 60);
+    }
+    {
+        log_t log(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(log.Load() && log.GetCount() == 48 && Walk(log, 48) == 60);
+
+        // Failed write, slot zeroed and skipped
+        s.seq = ++seq;
+        s.v[2] = s.seq * 3;
+        CHECK(log.Append(s) && log.GetCount() == 37);
+        s.seq = ++seq;
+        s.v[2] = s.seq * 3;
+        g_sim.FailNext(1);
+        CHECK(log.Append(s));
+        CHECK(log.GetCount() == 39);
+    }
+    {
+        log_t log(g_sim, g_sim.GetStart(), 4);
+        sample_t l;
+
+        CHECK(log.Load() && log.GetCount() == 39);
+        log_t::Iterator it(log, true);
+        CHECK(it.Get(l) && l.seq == 62);
+        CHECK(it.Previous() && !it.Get(l) && it.Previous() && it.Get(l) && l.seq == 61);
+
+        // Write and zeroing fail, slot kept and written on retry
+        s.seq = ++seq;
+        s.v[2] = s.seq * 3;
+        g_sim.FailNext(2);
+        CHECK(log.Append(s));
+        CHECK(log.GetCount() == 40);
+    }
+
+    // Power cut at each point of appends, reboot write position after the cut entry and appends readable
+    for(n = 0; n < 6; n++) {
+        {
+            log_t log(g_sim, g_sim.GetStart(), 4);
+
+            CHECK(log.Load());
+            g_sim.CutAfter(static_cast<int32_t>(n));
+            for(i = 0, done = true; done && i < 12; i++) {
+                s.seq = ++seq;
+                s.v[2] = s.seq * 3;
+                done = log.Append(s);
+            }
+            g_sim.Restore();
+        }
+        {
+            log_t log(g_sim, g_sim.GetStart(), 4);
+            sample_t l;
+
+            CHECK(log.Load());
+            count = log.GetCount();
+            s.seq = ++seq;
+            s.v[2] = s.seq * 3;
+            CHECK(log.Append(s) && (log.GetCount() == count + 1 || (count == 48 && log.GetCount() == 37)));    // Or page reclaimed
+            log_t::Iterator h(log, true);
+            CHECK(h.Get(l) && l.seq == seq);
+            CHECK(h.Previous() && !h.Get(l));
+        }
+    }
+
+    // Entries never written over after reboot, each damaged one a single slot
+    {
+        log_t log(g_sim, g_sim.GetStart(), 4);
+        sample_t l;
+
+        CHECK(log.Load());
+        damaged = 0;
+        for(log_t::Iterator it(log); it.IsValid(); it.Next()) {
+            if (!it.Get(l)) {
+                damaged++;
+            }else {
+                CHECK(l.v[2] == l.seq * 3);
+            }
+        }
+        CHECK(damaged <= 7);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,103 @@
+/**
+ * \file
+ * Test of Linux MTD media wrapper against a regular file standing in for the device, no mtdram module
+ * needed.  Build on Linux with any C++ compiler, e.g. "g++ -I.. mtdtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Linux
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+#include "../media.h"
+#include "../host/mtd.h"
+#include "../struct.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+// Stand in geometry
+#define ERASE_SIZE        4096
+#define BLOCKS            16
+
+typedef struct {
+    uint32_t    serial;
+    uint8_t     table[5000];    // 2 erase blocks per slot
+}cfg_t;
+
+
+int main() {
+    char path[] = "/tmp/mtdtestXXXXXX";
+    uint8_t e[ERASE_SIZE];
+    uint32_t b[8], r[8], i, n;
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    memset(e, 0xff, sizeof(e));
+    for(i = 0; i < BLOCKS; i++) {
+        CHECK(write(fd, e, sizeof(e)) == static_cast<ssize_t>(sizeof(e)));
+    }
+    close(fd);
+
+    wrap::Mtd mtd;
+
+    // Regular file is MTD only when emulation asked for
+    CHECK(!mtd.Open(path));
+    CHECK(mtd.Open(path, ERASE_SIZE));
+    CHECK(mtd.GetSize() == ERASE_SIZE * BLOCKS && mtd.GetPageSize() == ERASE_SIZE);
+
+    // NOR semantics, write clears bits only, erase sets
+    for(i = 0; i < 8; i++) {
+        b[i] = 0x0f0f0f0fUL;
+    }
+    CHECK(mtd.Write(mtd.GetStart() + 8, b, 8));
+    b[0] = 0xf0f0f0f0UL;
+    CHECK(mtd.Write(mtd.GetStart() + 8, b, 1));
+    CHECK(mtd.Read(mtd.GetStart() + 8, r, 8) && r[0] == 0 && r[1] == 0x0f0f0f0fUL);
+    CHECK(mtd.Erase(mtd.GetStart(), 1) && mtd.GetErases() == 1);
+    CHECK(mtd.Read(mtd.GetStart() + 8, r, 1) && r[0] == mtd.GetEraseState());
+    CHECK(!mtd.Erase(mtd.GetStart() + 1, 1) && !mtd.Read(mtd.GetEnd(), r, 1));
+
+    // Program erases its slot with one call, unchanged data not erased
+    b[0] = 1;
+    n = mtd.GetErases();
+    CHECK(mtd.Program(mtd.GetStart() + (ERASE_SIZE>>2) + 100, b, 8, ERASE_SIZE>>2, false));
+    CHECK(mtd.Program(mtd.GetStart() + (ERASE_SIZE>>2) + 100, b, 8, ERASE_SIZE>>2, false));
+    CHECK(mtd.GetErases() - n == 1);
+    b[0] = 2;
+    CHECK(mtd.Program(mtd.GetStart() + (ERASE_SIZE>>2) + 100, b, 8, ERASE_SIZE>>2, false));
+    CHECK(mtd.Read(mtd.GetStart() + (ERASE_SIZE>>2) + 100, r, 8) && !memcmp(b, r, sizeof(b)));
+
+    // Structure over whole partition, slot of 2 erase blocks is one erase per save
+    {
+        persist::Struct<cfg_t> ps(mtd, mtd.GetStart(), mtd.GetEnd());
+        cfg_t c;
+
+        memset(&c, 0x5a, sizeof(c));
+        CHECK(ps.Save(c, true));
+        n = mtd.GetErases();
+        for(i = 1; i <= 10; i++) {
+            c.serial = i;
+            CHECK(ps.Save(c));
+        }
+        std::cout << "saves       = 10, " << (mtd.GetErases() - n) << " erase calls" << std::endl;
+        CHECK(mtd.GetErases() - n == 10);
+    }
+    mtd.Close();
+    {
+        wrap::Mtd again;
+        CHECK(again.Open(path, ERASE_SIZE));
+
+        persist::Struct<cfg_t> ps(again, again.GetStart(), again.GetEnd());
+        cfg_t c;
+
+        CHECK(ps.Load(c) && c.serial == 10 && c.table[4999] == 0x5a);
+    }
+
+    unlink(path);
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,163 @@
+/**
+ * \file
+ * Host emulator of a SPI NOR flash device (W25Q16 class) for testing wrap::SpiNor without hardware.
+ * Bits program from 1 to 0 only, erase sets 1.  Page program wraps within its 256 Byte page as real
+ * devices do.  Busy is reported for a few status polls after each program or erase.
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#ifndef NORSIM_H
+#define NORSIM_H
+
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ * SPI NOR emulator, use \ref Transfer as wrap::SpiNor transfer function with emulator as context
+ *
+ * \tparam SIZE device size (Bytes), power of 2
+ */
+template<uint32_t SIZE>
+class NorSim {
+public:
+    NorSim() : wel_(false), busy_(0), programs_(0), erases4_(0), erases32_(0), erases64_(0), violations_(0) {
+        memset(mem_, 0xff, sizeof(mem_));
+    }
+
+    /**
+     * SPI transfer, see wrap::SpiNor::tTransfer
+     */
+    static bool Transfer(void *context, const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx,
+                            uint8_t *rx, const uint16_t size) {
+        return static_cast<NorSim*>(context)->Command(cmd, cmd_size, tx, rx, size);
+    }
+
+    uint8_t* GetMemory() {
+        return mem_;
+    }
+
+    uint32_t GetPrograms() const { return programs_; }
+    uint32_t GetErases4K() const { return erases4_; }
+    uint32_t GetErases32K() const { return erases32_; }
+    uint32_t GetErases64K() const { return erases64_; }
+
+    /**
+     * Get count of commands refused (busy, write not enabled) or programs crossing a page
+     */
+    uint32_t GetViolations() const { return violations_; }
+
+protected:
+    bool Command(const uint8_t *cmd, const uint8_t cmd_size, const uint8_t *tx, uint8_t *rx, const uint16_t size) {
+        uint32_t a = (cmd_size >= 4) ? ((static_cast<uint32_t>(cmd[1]) << 16) | (cmd[2] << 8) | cmd[3]) % SIZE : 0;
+        uint32_t i;
+
+        // Only status read allowed while busy
+        if (busy_ && cmd[0] != 0x05) {
+            violations_++;
+            return true;
+        }
+
+        switch(cmd[0]) {
+        case 0x9f:    // JEDEC ID, Winbond, SPI, log2(SIZE)
+            for(i = 0; i < size; i++) {
+                rx[i] = (i == 0) ? 0xef : (i == 1) ? 0x40 : static_cast<uint8_t>(Log2());
+            }
+            break;
+
+        case 0x05:    // Status
+            for(i = 0; i < size; i++) {
+                rx[i] = static_cast<uint8_t>((busy_ ? 0x01 : 0) | (wel_ ? 0x02 : 0));
+                if (busy_) {
+                    busy_--;
+                }
+            }
+            break;
+
+        case 0x06:
+            wel_ = true;
+            break;
+
+        case 0x04:
+            wel_ = false;
+            break;
+
+        case 0x03:    // Read, wraps at device end
+            for(i = 0; i < size; i++) {
+                rx[i] = mem_[(a + i) % SIZE];
+            }
+            break;
+
+        case 0x02:    // Page program, wraps within page
+            if (!wel_) {
+                violations_++;
+                break;
+            }
+            if ((a & 0xff) + size > 256) {
+                violations_++;
+            }
+            for(i = 0; i < size; i++) {
+                mem_[(a & ~0xffUL) | ((a + i) & 0xff)] &= tx[i];
+            }
+            programs_++;
+            Busy(3);
+            break;
+
+        case 0x20:
+            Erase(a, 0x1000, erases4_);
+            break;
+
+        case 0x52:
+            Erase(a, 0x8000, erases32_);
+            break;
+
+        case 0xd8:
+            Erase(a, 0x10000, erases64_);
+            break;
+
+        default:
+            violations_++;
+            break;
+        }
+
+        return true;
+    }
+
+    void Erase(const uint32_t a, const uint32_t bytes, uint32_t &count) {
+        if (wel_) {
+            memset(&mem_[a & ~(bytes - 1)], 0xff, bytes);
+            count++;
+            Busy(10);
+        }else {
+            violations_++;
+        }
+    }
+
+    void Busy(const uint32_t polls) {
+        busy_ = polls;
+        wel_ = false;
+    }
+
+    static uint32_t Log2() {
+        uint32_t n = 0;
+
+        while((1UL << n) < SIZE) {
+            n++;
+        }
+
+        return n;
+    }
+
+protected:
+    uint8_t     mem_[SIZE];
+    bool        wel_;
+    uint32_t    busy_;
+    uint32_t    programs_;
+    uint32_t    erases4_;
+    uint32_t    erases32_;
+    uint32_t    erases64_;
+    uint32_t    violations_;
+}; // class NorSim
+
+#endif // NORSIM_H
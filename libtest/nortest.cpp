@@ -0,0 +1,113 @@
+/**
+ * \file
+ * Test of SPI NOR flash media wrapper against host emulator, no hardware.  Build with any C++ compiler,
+ * e.g. "g++ -I.. nortest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../ext/spinor.h"
+#include "../struct.h"
+#include "../log.h"
+#include "norsim.h"
+
+#define NOR_SIZE        (2UL * 1024 * 1024)
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    serial;
+    uint8_t     name[300];
+}cfg_t;
+
+NorSim<NOR_SIZE> g_sim;
+uint32_t g_large[20000], g_large_read[20000];     // Above 0xffff Bytes
+
+
+int main() {
+    wrap::SpiNor nor(NorSim<NOR_SIZE>::Transfer, &g_sim);
+    uint32_t b[150], r[150], i;
+
+    // Probe
+    CHECK(nor.Probe());
+    CHECK(nor.GetId() == 0xef4015UL);
+    CHECK(nor.GetSize() == NOR_SIZE);
+    CHECK(nor.GetPageSize() == 4096 && nor.GetProgramSize() == 256);
+    std::cout << "probe       = " << std::hex << nor.GetId() << std::dec << ", " << nor.GetSize() << " Bytes" << std::endl;
+
+    // Write crossing program pages is split
+    for(i = 0; i < 150; i++) {
+        b[i] = i * 0x01010101UL;
+    }
+    CHECK(nor.Write(nor.GetStart() + 50, b, 150));
+    CHECK(nor.Read(nor.GetStart() + 50, r, 150));
+    CHECK(!memcmp(b, r, sizeof(b)));
+    CHECK(g_sim.GetPrograms() == 4 && !g_sim.GetViolations());
+
+    // Erase selection, 64KB + 32KB + 4KB from 64KB aligned
+    CHECK(nor.Erase(nor.GetStart() + (0x10000 >> 2), 25));
+    CHECK(g_sim.GetErases64K() == 1 && g_sim.GetErases32K() == 1 && g_sim.GetErases4K() == 1);
+    CHECK(nor.Erase(nor.GetStart(), 1));
+    CHECK(nor.Read(nor.GetStart() + 50, r, 1) && r[0] == nor.GetEraseState());
+
+    // Persistent structure on 4KB sectors
+    {
+        persist::Struct<cfg_t> ps(nor, nor.GetStart(), 4);
+        cfg_t c;
+
+        memset(&c, 0, sizeof(c));
+        CHECK(!ps.Load(c));
+        CHECK(ps.Save(c, true));
+        for(i = 1; i <= 20; i++) {
+            c.serial = i;
+            CHECK(ps.Save(c));
+        }
+    }
+    {
+        persist::Struct<cfg_t> ps(nor, nor.GetStart(), 4);
+        cfg_t c;
+
+        CHECK(ps.Load(c) && c.serial == 20 && ps.GetCounter() == 20);
+    }
+
+    // Log appends without erase per write
+    {
+        persist::Log<uint32_t> log(nor, nor.GetStart() + (0x100000 >> 2), 4);
+        uint32_t e = g_sim.GetErases4K() + g_sim.GetErases32K() + g_sim.GetErases64K();
+
+        CHECK(log.Load());
+        for(i = 0; i < 1000; i++) {
+            CHECK(log.Append(i));
+        }
+        CHECK(g_sim.GetErases4K() + g_sim.GetErases32K() + g_sim.GetErases64K() - e <= 4);
+
+        persist::Log<uint32_t> again(nor, nor.GetStart() + (0x100000 >> 2), 4);
+        CHECK(again.Load() && again.GetCount() == log.GetCount());
+    }
+
+    // Read above 16bit transfer size is split
+    for(i = 0; i < 20000; i++) {
+        g_large[i] = i * 0x9e3779b9UL;
+    }
+    CHECK(nor.Erase(nor.GetStart() + (0x180000 >> 2), 20));
+    CHECK(nor.Write(nor.GetStart() + (0x180000 >> 2), g_large, 20000));
+    CHECK(nor.Read(nor.GetStart() + (0x180000 >> 2), g_large_read, 20000));
+    CHECK(!memcmp(g_large, g_large_read, sizeof(g_large)));
+
+    CHECK(!g_sim.GetViolations());
+    std::cout << "programs    = " << g_sim.GetPrograms() << std::endl;
+    std::cout << "erases      = " << g_sim.GetErases4K() << " x 4KB, " << g_sim.GetErases32K() << " x 32KB, " << \
+                    g_sim.GetErases64K() << " x 64KB" << std::endl;
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
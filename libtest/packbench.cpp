@@ -0,0 +1,101 @@
+/**
+ * \file
+ * Benchmark for bit packed persistent structure encode/decode cost against storage bytes saved.
+ * Host build, no media access.  Build with any C++ compiler, e.g. "g++ -O2 -I.. packbench.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+
+#include "../media.h"
+#include "../pack.h"
+
+// Encode/decode iterations
+#define ITERATIONS        2000000
+
+/**
+ * Test structure resembling an application configuration, natural alignment and padding
+ */
+typedef struct {
+    uint8_t  mode;          // 0..5
+    uint16_t rate;          // 0..1000
+    int16_t  offset;        // -256..255
+    uint32_t serial;        // full range
+    bool     enable;
+    uint8_t  str[6];        // 7bit ASCII
+    int8_t   trim[8];       // -16..15
+}cfg_t;
+
+typedef persist::PackField<cfg_t, uint8_t,  &cfg_t::mode,   3, 0,
+        persist::PackField<cfg_t, uint16_t, &cfg_t::rate,   10, 0,
+        persist::PackField<cfg_t, int16_t,  &cfg_t::offset, 9, -256,
+        persist::PackField<cfg_t, uint32_t, &cfg_t::serial, 32, 0,
+        persist::PackField<cfg_t, bool,     &cfg_t::enable, 1, 0,
+        persist::PackArray<cfg_t, uint8_t, 6, &cfg_t::str,  7, 0,
+        persist::PackArray<cfg_t, int8_t,  8, &cfg_t::trim, 5, -16> > > > > > > cfg_schema_t;
+
+typedef persist::Packed<cfg_t, cfg_schema_t> packed_t;
+
+
+/**
+ * Benchmark entry point
+ *
+ * @return int Status
+ * @retval 0 Success
+ * @retval 1 Failure
+ */
+int main() {
+    cfg_t c, d;
+    packed_t::tPacked p;
+    uint32_t sum = 0;
+    clock_t t0, t1, t2;
+
+    memset(&c, 0, sizeof(c));
+    c.mode = 5;
+    c.rate = 999;
+    c.offset = -200;
+    c.serial = 0xcafef00dUL;
+    c.enable = true;
+    memcpy(c.str, "HELLO", 6);
+    for(int i = 0; i < 8; i++) {
+        c.trim[i] = static_cast<int8_t>(i * 4 - 16);
+    }
+
+    // Round trip check
+    memset(&d, 0, sizeof(d));
+    packed_t::Encode(c, p);
+    packed_t::Decode(p, d);
+    if (memcmp(&c, &d, sizeof(c))) {
+        std::cerr << "ERROR: decode mismatch" << std::endl;
+        return 1;
+    }
+
+    t0 = clock();
+    for(uint32_t i = 0; i < ITERATIONS; i++) {
+        c.serial = i;
+        packed_t::Encode(c, p);
+        sum+= p.b[3];
+    }
+    t1 = clock();
+    for(uint32_t i = 0; i < ITERATIONS; i++) {
+        p.b[3] = static_cast<uint8_t>(i);
+        packed_t::Decode(p, d);
+        sum+= d.serial;
+    }
+    t2 = clock();
+
+    std::cout << "structure size      " << std::dec << sizeof(cfg_t) << " Bytes, stored " << persist::Struct<cfg_t>::GetStorageUnitSize() << " Bytes" << std::endl;
+    std::cout << "packed size         " << sizeof(p.b) << " Bytes (" << static_cast<uint32_t>(cfg_schema_t::bits) << " bits), stored " << packed_t::GetStorageUnitSize() << " Bytes" << std::endl;
+    std::cout << "saved per copy      " << (persist::Struct<cfg_t>::GetStorageUnitSize() - packed_t::GetStorageUnitSize()) << " Bytes" << std::endl;
+    std::cout << "encode              " << std::fixed << std::setprecision(1) << (1e9 * (t1 - t0) / CLOCKS_PER_SEC / ITERATIONS) << " ns" << std::endl;
+    std::cout << "decode              " << std::fixed << std::setprecision(1) << (1e9 * (t2 - t1) / CLOCKS_PER_SEC / ITERATIONS) << " ns" << std::endl;
+    std::cout << "(checksum " << std::hex << sum << ")" << std::endl;
+
+    return 0;
+} // int main(...)
@@ -0,0 +1,132 @@
+/**
+ * \file
+ * Test of bit packed persistent structure on media, save and reload across reboot, saturation, members
+ * not described and recovery from a corrupted newest slot.  Build with any C++ compiler, e.g.
+ * "g++ -I.. packtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "../pack.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint8_t  mode;          // 0..5
+    uint16_t rate;          // 0..1000
+    int16_t  offset;        // -256..255
+    uint32_t serial;        // full range
+    bool     enable;
+    uint8_t  str[6];        // 7bit ASCII
+    int8_t   trim[8];       // -16..15
+    uint32_t scratch;       // Not stored
+}cfg_t;
+
+typedef persist::PackField<cfg_t, uint8_t,  &cfg_t::mode,   3, 0,
+        persist::PackField<cfg_t, uint16_t, &cfg_t::rate,   10, 0,
+        persist::PackField<cfg_t, int16_t,  &cfg_t::offset, 9, -256,
+        persist::PackField<cfg_t, uint32_t, &cfg_t::serial, 32, 0,
+        persist::PackField<cfg_t, bool,     &cfg_t::enable, 1, 0,
+        persist::PackArray<cfg_t, uint8_t, 6, &cfg_t::str,  7, 0,
+        persist::PackArray<cfg_t, int8_t,  8, &cfg_t::trim, 5, -16> > > > > > > cfg_schema_t;
+
+typedef persist::Packed<cfg_t, cfg_schema_t> packed_t;
+typedef persist::Packed<cfg_t, cfg_schema_t, persist::HeadCompact> compact_t;
+
+FlashSim<64, 16> g_sim;
+
+
+/**
+ * Compare described members
+ */
+static bool IsSame(const cfg_t &a, const cfg_t &b) {
+    return a.mode == b.mode && a.rate == b.rate && a.offset == b.offset && a.serial == b.serial && \
+            a.enable == b.enable && !memcmp(a.str, b.str, sizeof(a.str)) && !memcmp(a.trim, b.trim, sizeof(a.trim));
+}
+
+
+int main() {
+    uint32_t *compact = g_sim.GetStart() + ((8 * 64)>>2);
+    uint32_t i, location;
+    cfg_t c, l;
+
+    memset(&c, 0, sizeof(c));
+    c.mode = 5;
+    c.rate = 999;
+    c.offset = -200;
+    c.serial = 0xcafef00dUL;
+    c.enable = true;
+    memcpy(c.str, "HELLO", 6);
+    for(i = 0; i < 8; i++) {
+        c.trim[i] = static_cast<int8_t>(i * 4 - 16);
+    }
+
+    // Smaller than the plain structure
+    CHECK(packed_t::GetStorageUnitSize() < persist::Struct<cfg_t>::GetStorageUnitSize());
+    CHECK(compact_t::GetStorageUnitSize() < packed_t::GetStorageUnitSize());
+
+    // Save, reboot, load
+    {
+        packed_t ps(g_sim, g_sim.GetStart(), 8);
+        compact_t cs(g_sim, compact, 8);
+
+        CHECK(!ps.Load(l) && !cs.Load(l));
+        CHECK(ps.Save(c, true) && cs.Save(c, true));
+        for(i = 1; i <= 10; i++) {
+            c.serial = i;
+            CHECK(ps.Save(c) && cs.Save(c));
+        }
+    }
+    {
+        packed_t ps(g_sim, g_sim.GetStart(), 8);
+        compact_t cs(g_sim, compact, 8);
+
+        memset(&l, 0, sizeof(l));
+        l.scratch = 1234;
+        CHECK(ps.Load(l) && IsSame(c, l) && l.scratch == 1234);
+        CHECK(ps.GetStruct().GetCounter() == 10);
+        memset(&l, 0, sizeof(l));
+        CHECK(cs.Load(l) && IsSame(c, l));
+    }
+
+    // Out of range values saturate to range limits
+    {
+        packed_t ps(g_sim, g_sim.GetStart(), 8);
+
+        CHECK(ps.Load(l));
+        l.rate = 2000;
+        l.offset = -1000;
+        l.trim[0] = 100;
+        CHECK(ps.Save(l));
+    }
+    {
+        packed_t ps(g_sim, g_sim.GetStart(), 8);
+
+        CHECK(ps.Load(l) && l.rate == 1023 && l.offset == -256 && l.trim[0] == 15 && l.serial == 10);
+        location = static_cast<uint32_t>(ps.GetStruct().GetLocation() - g_sim.GetStart()) * sizeof(uint32_t);
+    }
+
+    // Newest slot corrupted, copy before loaded
+    g_sim.GetMemory()[location + 14]^= 0x10;
+    {
+        packed_t ps(g_sim, g_sim.GetStart(), 8);
+
+        memset(&l, 0, sizeof(l));
+        CHECK(ps.Load(l) && IsSame(c, l) && ps.GetStruct().GetCounter() == 10);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
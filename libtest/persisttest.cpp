@@ -191,12 +191,17 @@ uint8_t boot_spm_busy_wait(void) {
 
 #define optiboot_addr_t    uint32_t
 
+// page buffer words filled since last page write.  filled from page start, whole page written as before
+uint8_t pageFilled[TEST_PAGE_SIZE/sizeof(uint16_t)];
+
 void optiboot_page_fill(optiboot_addr_t address, uint16_t data) {
     uint16_t *pb = (uint16_t*)pageBuffer;
     uint32_t o = (((uint32_t)address) % TEST_PAGE_SIZE)/sizeof(uint16_t);
     if (!o) {
         memset(&pageBuffer, -1, sizeof(pageBuffer));
+        memset(&pageFilled, 1, sizeof(pageFilled));
     }
+    pageFilled[o] = 1;
 #if defined(LOWLEVEL_DEBUG)
     std::cout << "_SPM_FILL(" << std::hex << std::setw(8) << std::setfill('0') << (uint32_t)&pb[o] << ")" << " = " << data << std::endl;
 #endif
@@ -232,7 +237,16 @@ void optiboot_page_write(optiboot_addr_t address) {
         pageBuffer[i] ^= 0xff;
         write_error_inject = false;
     }
-    memcpy((void*)address, &pageBuffer, sizeof(pageBuffer));
+
+    // write filled words to page, address may be part way into page (Media::Write)
+    uint16_t *p = (uint16_t*)(address - (address % TEST_PAGE_SIZE));
+    uint16_t *pb = (uint16_t*)pageBuffer;
+    for(uint32_t i=0; i<sizeof(pageFilled); i++) {
+        if (pageFilled[i]) {
+            p[i] = pb[i];
+        }
+    }
+    memset(&pageFilled, 0, sizeof(pageFilled));
 }
 
 uint32_t eeprom_read_dword(const uint32_t *__p)    {
@@ -275,6 +289,7 @@ uint16_t pgm_read_word(uint32_t __p) {
 #endif // defined(AVR8MEGA_FLASH)
 #include "../mega/wrap.h"
 #include "../struct.h"
+#include "../log.h"
 
 #if defined(AVR8MEGA_EE)
 // succesful test crc's (EE)
@@ -704,6 +719,41 @@ int _tmain(int argc, _TCHAR* argv[]) {
         d->str[4] = tmp;
     } // for(uint32_t wr=0...)
 
+#if defined(AVR8MEGA_FLASH)
+    // Log entries written part way into pages without erase (Flash::Write), then found again after reload
+    {
+        persist::Log<cfg_t> g(f, f.GetStart(), 4);
+        cfg_t e;
+
+        Pset(0xffffffff);
+        memset(&e, 0, sizeof(e));
+        for(uint32_t i=0; i<20; i++) {
+            e.os = i;
+            if (!g.Append(e)) {
+                std::cerr << std::endl << "ERROR: log append failed " << i << std::endl << std::endl;
+                return 1;
+            }
+        }
+    }
+    {
+        persist::Log<cfg_t> g(f, f.GetStart(), 4);
+        cfg_t e;
+        uint32_t n = 0;
+
+        if (!g.Load() || g.GetCount() != 20) {
+            std::cerr << std::endl << "ERROR: log load failed" << std::endl << std::endl;
+            return 1;
+        }
+        for(persist::Log<cfg_t>::Iterator it(g); it.IsValid(); it.Next(), n++) {
+            if (!it.Get(e) || e.os != n) {
+                std::cerr << std::endl << "ERROR: log entry " << n << " bad" << std::endl << std::endl;
+                return 1;
+            }
+        }
+        std::cout << std::endl << "log entries ok " << std::dec << n << std::endl << std::endl;
+    }
+#endif // defined(AVR8MEGA_FLASH)
+
     std::cout << "all tests complete" << std::endl;
 
     return 0;
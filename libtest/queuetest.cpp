@@ -0,0 +1,158 @@
+/**
+ * \file
+ * Test of persistent FIFO queue, full ring, wrap, reboot and failed push or pop never losing or
+ * repeating unconsumed entries.  Build with any C++ compiler, e.g. "g++ -I.. queuetest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../queue.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    id;
+    uint32_t    body[2];
+}msg_t;
+
+typedef persist::Queue<msg_t> queue_t;
+
+FlashSim<128, 4> g_sim;
+
+
+int main() {
+    msg_t m;
+    uint32_t i, push = 0, pop = 0;
+
+    memset(&m, 0, sizeof(m));
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(q.Load() && q.GetCount() == 0 && q.GetEntriesPerPage() == 7 && !q.Peek(m));
+
+        // Fill ring, tail page not reused
+        for(i = 0; i < 28; i++) {
+            m.id = ++push;
+            CHECK(q.Push(m));
+        }
+        CHECK(q.IsFull() && q.GetCount() == 28);
+        m.id = 1000;
+        CHECK(!q.Push(m) && q.GetCount() == 28);
+
+        // Consume part of the oldest page
+        for(i = 0; i < 3; i++) {
+            CHECK(q.Pop(m) && m.id == ++pop);
+        }
+    }
+
+    // Reboot, front of queue part way into oldest page
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(q.Load() && q.GetCount() == 25 && q.Peek(m) && m.id == 4);
+
+        // Rest of oldest page, erased, ring wraps
+        for(i = 0; i < 4; i++) {
+            CHECK(q.Pop(m) && m.id == ++pop);
+        }
+        CHECK(!q.IsFull() && q.GetCount() == 21);
+        for(i = 0; i < 6; i++) {
+            m.id = ++push;
+            CHECK(q.Push(m));
+        }
+        CHECK(q.GetCount() == 27 && !q.IsFull());
+
+        // Last free slot, failed write doesn't open (erase) the oldest page
+        m.id = ++push;
+        g_sim.FailNext(1);
+        CHECK(!q.Push(m) && q.IsFull());
+        CHECK(q.GetCount() == 28 && q.Peek(m) && m.id == pop + 1);
+        push--;
+    }
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        // All queued entries still there, damaged one last
+        CHECK(q.Load() && q.GetCount() == 28);
+        for(i = 0; i < 27; i++) {
+            CHECK(q.Pop(m) && m.id == ++pop);
+        }
+        CHECK(!q.Peek(m) && q.GetCount() == 0);
+    }
+
+    // Failed pop, entry stays at front also after reboot
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(q.Load());
+        for(i = 0; i < 10; i++) {
+            m.id = ++push;
+            CHECK(q.Push(m));
+        }
+        CHECK(q.Pop(m) && m.id == ++pop);
+        g_sim.FailNext(1);
+        CHECK(!q.Pop() && q.GetCount() == 9 && q.Peek(m) && m.id == pop + 1);
+    }
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(q.Load() && q.GetCount() == 9 && q.Peek(m) && m.id == pop + 1);
+
+        // Failed push mid queue, damaged entry consumed, following entries still found after reboot
+        m.id = ++push;
+        g_sim.FailNext(1);
+        CHECK(q.Push(m) && q.GetCount() == 11);
+        m.id = ++push;
+        CHECK(q.Push(m));
+    }
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(q.Load() && q.GetCount() == 12);
+        for(i = 0; i < 11; i++) {
+            CHECK(q.Pop(m) && m.id == ++pop);
+        }
+        CHECK(q.GetCount() == 0);
+    }
+
+    // Failed erase of consumed page, entry removed and page kept until erased by next pop
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+        uint32_t failed = 0;
+        bool done;
+
+        CHECK(q.Load());
+        for(i = 0; i < 14; i++) {
+            m.id = ++push;
+            CHECK(q.Push(m));
+        }
+        for(i = 0; i < 14; i++) {
+            CHECK(q.Peek(m) && m.id == ++pop);
+            g_sim.CutAfter(1);
+            done = q.Pop();
+            g_sim.Restore();
+            CHECK(q.GetCount() == 14 - 1 - i);
+            failed+= done ? 0 : 1;
+        }
+        CHECK(failed == 2 && !q.Peek(m));
+    }
+    {
+        queue_t q(g_sim, g_sim.GetStart(), 4);
+
+        CHECK(q.Load() && q.GetCount() == 0);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,142 @@
+/**
+ * \file
+ * Test of storage region after the firmware image, image end by scan for the first erased page and from
+ * the wrapper, firmware growth into headroom keeping the newest record and growth past headroom.
+ * Build with any C++ compiler, e.g. "g++ -I.. regiontest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "../region.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+#define PAGE_U32        (64>>2)
+
+typedef struct {
+    uint32_t serial;
+    uint32_t value;
+    uint8_t  spare[8];
+}cfg_t;
+
+typedef persist::Struct<cfg_t> ps_t;
+
+/**
+ * Flash with image end from linker symbols when set
+ */
+class ImageSim : public FlashSim<64, 32> {
+public:
+    ImageSim() : image_end_(NULL) {}
+
+    void SetImageEnd(uint32_t *end) {
+        image_end_ = end;
+    }
+
+    uint32_t* GetImageEnd() const {
+        return image_end_;
+    }
+
+protected:
+    uint32_t    *image_end_;
+};
+
+ImageSim g_sim;
+
+
+/**
+ * Write firmware image of given pages at media start
+ */
+static void Flash(const uint32_t pages) {
+    memset(g_sim.GetMemory(), 0x5a, pages * 64);
+}
+
+
+int main() {
+    uint32_t i;
+    cfg_t c, l;
+
+    memset(&c, 0, sizeof(c));
+
+    // Image end by scan, region after 4 pages headroom
+    Flash(5);
+    {
+        persist::Region r(g_sim, ps_t::GetStorageUnitSize(), 4);
+        ps_t ps(g_sim, r.GetStart(), r.GetEnd());
+
+        CHECK(r.GetImageEnd() == g_sim.GetStart() + 5 * PAGE_U32);
+        CHECK(r.GetStart() == g_sim.GetStart() + 9 * PAGE_U32 && r.GetEnd() == g_sim.GetEnd());
+        CHECK(r.GetSlots() == 23 && r.GetPages() == 23);
+        CHECK(!ps.Load(l) && ps.Save(c, true));
+        for(i = 1; i <= 30; i++) {
+            c.value = i;
+            CHECK(ps.Save(c));
+        }
+    }
+
+    // Firmware grows 3 pages into headroom, erased page still follows image.  Start is kept
+    Flash(8);
+    {
+        persist::Region r(g_sim, ps_t::GetStorageUnitSize(), 4);
+        ps_t ps(g_sim, r.GetStart(), r.GetEnd());
+
+        CHECK(r.GetImageEnd() == g_sim.GetStart() + 8 * PAGE_U32);
+        CHECK(r.GetStart() == g_sim.GetStart() + 9 * PAGE_U32);
+        CHECK(ps.Load(l) && l.value == 30);
+        c.value = 31;
+        CHECK(ps.Save(c));
+    }
+
+    // Growth by all headroom leaves no erased page after the image, scan runs past the region
+    Flash(9);
+    {
+        persist::Region r(g_sim, ps_t::GetStorageUnitSize(), 4);
+
+        CHECK(r.GetImageEnd() == g_sim.GetEnd() && r.GetSlots() == 0);
+    }
+
+    // Image end from wrapper, growth by all headroom keeps start and newest record
+    g_sim.SetImageEnd(g_sim.GetStart() + 9 * PAGE_U32);
+    {
+        persist::Region r(g_sim, ps_t::GetStorageUnitSize(), 4);
+        ps_t ps(g_sim, r.GetStart(), r.GetEnd());
+
+        CHECK(r.GetImageEnd() == g_sim.GetStart() + 9 * PAGE_U32);
+        CHECK(r.GetStart() == g_sim.GetStart() + 9 * PAGE_U32);
+        CHECK(ps.Load(l) && l.value == 31);
+    }
+
+    // Growth past headroom, region starts after the image
+    Flash(10);
+    g_sim.SetImageEnd(g_sim.GetStart() + 10 * PAGE_U32);
+    {
+        persist::Region r(g_sim, ps_t::GetStorageUnitSize(), 4);
+
+        CHECK(r.GetStart() == g_sim.GetStart() + 10 * PAGE_U32 && r.GetSlots() == 22);
+    }
+
+    // Region never written, start past headroom.  Slots of 2 pages counted from media end
+    g_sim.SetImageEnd(NULL);
+    memset(g_sim.GetMemory(), 0xff, 32 * 64);
+    Flash(5);
+    {
+        persist::Region r(g_sim, 65, 4);
+
+        CHECK(r.GetImageEnd() == g_sim.GetStart() + 5 * PAGE_U32);
+        CHECK(r.GetStart() == g_sim.GetStart() + 10 * PAGE_U32 && r.GetSlots() == 11 && r.GetPages() == 22);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
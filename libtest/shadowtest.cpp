@@ -0,0 +1,174 @@
+/**
+ * \file
+ * Test of warm reset shadow, load from a valid shadow without scanning and fall back to a scan when the
+ * shadow is corrupted, stale after a save it missed or invalidated by an interrupted save.
+ * Build with any C++ compiler, e.g. "g++ -I.. shadowtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    value;
+    uint8_t     name[20];
+}cfg_t;
+
+typedef persist::Struct<cfg_t> ps_t;
+
+FlashSim<64, 16> g_sim;
+ps_t::tShadow g_shadow;         // .noinit on target
+
+
+int main() {
+    ps_t::tShadow stale;
+    uint32_t i;
+    cfg_t c, l;
+
+    memset(&c, 0, sizeof(c));
+    memset(&g_shadow, 0x5a, sizeof(g_shadow));      // Power up RAM content
+
+    // Power up, shadow not valid so scan, then shadow taken
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachShadow(&g_shadow);
+        CHECK(!ps.Load(l));
+        for(i = 1; i <= 5; i++) {
+            c.value = i;
+            CHECK(ps.Save(c, i == 1));
+        }
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        memset(&g_shadow, 0x5a, sizeof(g_shadow));
+        ps.AttachShadow(&g_shadow);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5);
+        CHECK(g_sim.GetReads() > 2);
+    }
+
+    // Warm reset, valid shadow.  Header at location and following header only
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachShadow(&g_shadow);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5 && ps.GetCounter() == 4);
+        CHECK(g_sim.GetReads() == 2 && g_sim.GetReadWords() == 2 * sizeof(persist::HeadStd::tHead) / sizeof(uint32_t));
+    }
+
+    // Corrupted shadow data, guard or location.  Scan
+    for(i = 0; i < 3; i++) {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+        ps_t::tShadow keep = g_shadow;
+
+        if (i == 0) {
+            reinterpret_cast<uint8_t*>(&g_shadow.db)[sizeof(g_shadow.db) - 1]^= 1;
+        }else if (i == 1) {
+            g_shadow.check^= 1;
+        }else {
+            g_shadow.offset+= 1;
+        }
+        ps.AttachShadow(&g_shadow);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 5 && ps.GetCounter() == 4);
+        CHECK(g_sim.GetReads() > 2);
+
+        // Valid again after load
+        CHECK(!memcmp(&g_shadow, &keep, sizeof(keep)));
+    }
+
+    // Stale shadow, save made without it (not attached or reset before update).  Following header newer, scan
+    stale = g_shadow;
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        CHECK(ps.Load(l));
+        c.value = 6;
+        CHECK(ps.Save(c));
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        g_shadow = stale;
+        ps.AttachShadow(&g_shadow);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 6 && ps.GetCounter() == 5);
+        CHECK(g_sim.GetReads() > 2);
+    }
+
+    // Shadow updated by save, next warm reset without scan
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachShadow(&g_shadow);
+        CHECK(ps.Load(l));
+        c.value = 7;
+        CHECK(ps.Save(c));
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachShadow(&g_shadow);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 7 && g_sim.GetReads() == 2);
+    }
+
+    // Save interrupted by reset, shadow invalidated before write
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachShadow(&g_shadow);
+        CHECK(ps.Load(l));
+        c.value = 8;
+        g_sim.CutAfter(1);
+        CHECK(!ps.Save(c));
+        g_sim.Restore();
+        CHECK(g_shadow.magic == 0);
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        ps.AttachShadow(&g_shadow);
+        g_sim.Clear();
+        CHECK(ps.Load(l) && l.value == 7);
+        CHECK(g_sim.GetReads() > 2);
+    }
+
+    // Slot of shadow overwritten since (ring wrapped), header differs, scan
+    stale = g_shadow;
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        CHECK(ps.Load(l));
+        for(i = 0; i < 8; i++) {
+            c.value = 100 + i;
+            CHECK(ps.Save(c));
+        }
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 8);
+
+        g_shadow = stale;
+        ps.AttachShadow(&g_shadow);
+        CHECK(ps.Load(l) && l.value == 107);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,110 @@
+/**
+ * \file
+ * Test of first save slot search when not loaded, write counter continued from stale headers and the
+ * slot written found by the next load, also after the ring grows.  Build with any C++ compiler, e.g.
+ * "g++ -I.. slotsearchtest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t serial;
+    uint32_t value;
+    uint8_t  spare[8];
+}cfg_t;
+
+typedef persist::Struct<cfg_t> ps_t;
+
+FlashSim<64, 16> g_sim;
+
+
+int main() {
+    uint32_t i;
+    cfg_t c, l;
+
+    memset(&c, 0, sizeof(c));
+
+    // Virgin media, first slot with counter 0 as without search
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 3);
+
+        ps.SetSlotSearch(true);
+        CHECK(!ps.Load(l));
+        CHECK(ps.Save(c, true));
+        CHECK(ps.GetLocation() == g_sim.GetStart() && ps.GetCounter() == 0);
+
+        // Counters 0..4 in a 3 slot ring, newest in slot 1
+        for(i = 1; i <= 4; i++) {
+            c.value = i;
+            CHECK(ps.Save(c));
+        }
+        CHECK(ps.GetLocation() == g_sim.GetStart() + (64>>2));
+    }
+
+    // Ring grown to 6 slots (firmware update), factory reset.  Slot after newest is taken, not the
+    // first erased further along
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 6);
+
+        ps.SetSlotSearch(true);
+        c.value = 5;
+        CHECK(ps.Save(c, true));
+        CHECK(ps.GetLocation() == g_sim.GetStart() + ((2 * 64)>>2) && ps.GetCounter() == 5);
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 6);
+
+        CHECK(ps.Load(l) && l.value == 5 && ps.GetCounter() == 5);
+        for(i = 6; i <= 8; i++) {
+            c.value = i;
+            CHECK(ps.Save(c));
+        }
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 6);
+
+        CHECK(ps.Load(l) && l.value == 8 && ps.GetCounter() == 8);
+    }
+
+    // Factory reset where the newest slot is the last, wraps to the first
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 6);
+
+        ps.SetSlotSearch(true);
+        c.value = 9;
+        CHECK(ps.Save(c, true));
+        CHECK(ps.GetLocation() == g_sim.GetStart() && ps.GetCounter() == 9);
+    }
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 6);
+
+        CHECK(ps.Load(l) && l.value == 9 && ps.GetCounter() == 9);
+    }
+
+    // Without search the first slot restarts at counter 0
+    {
+        ps_t ps(g_sim, g_sim.GetStart(), 6);
+
+        c.value = 10;
+        CHECK(ps.Save(c, true));
+        CHECK(ps.GetLocation() == g_sim.GetStart() && ps.GetCounter() == 0);
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
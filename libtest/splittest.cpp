@@ -0,0 +1,99 @@
+/**
+ * \file
+ * Test of hot/cold split persistent structure, including power cut at every point of a save changing
+ * both parts.  Build with any C++ compiler, e.g. "g++ -I.. splittest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../struct.h"
+#include "../split.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+typedef struct {
+    uint32_t    run_hours;
+    uint8_t     last_mode;
+}hot_t;
+
+typedef struct {
+    uint8_t     serial[16];
+    int16_t     calibration[32];
+    hot_t       hot;
+}cfg_t;
+
+typedef persist::Split<cfg_t, hot_t, &cfg_t::hot> split_t;
+
+FlashSim<256, 16> g_sim;
+uint8_t g_image[256 * 16];
+
+
+int main() {
+    uint32_t *cold = g_sim.GetStart(), *hot = g_sim.GetStart() + ((4 * 256)>>2);
+    uint32_t n, counter;
+    bool done;
+    cfg_t c, l;
+
+    memset(&c, 0, sizeof(c));
+    memcpy(c.serial, "SERIAL-A", 8);
+    c.hot.run_hours = 1;
+    {
+        split_t ps(g_sim, cold, 4, hot, 8);
+
+        CHECK(!ps.Load(l));
+
+        // Not loaded, nothing written without force
+        CHECK(!ps.Save(c) && g_sim.GetWrites() == 0 && g_sim.GetErases() == 0);
+        CHECK(ps.Save(c, true));
+
+        // Hot change writes hot ring only
+        counter = ps.GetCold().GetCounter();
+        c.hot.run_hours = 2;
+        CHECK(ps.Save(c));
+        CHECK(ps.GetCold().GetCounter() == counter && ps.GetHot().GetCounter() == 1);
+    }
+    {
+        split_t ps(g_sim, cold, 4, hot, 8);
+
+        CHECK(ps.Load(l) && l.hot.run_hours == 2 && !memcmp(l.serial, "SERIAL-A", 8));
+    }
+
+    // Power cut after each write or erase of a save changing both parts.  Never new cold with old hot
+    memcpy(g_image, g_sim.GetMemory(), sizeof(g_image));
+    for(n = 0, done = false; !done; n++) {
+        memcpy(g_sim.GetMemory(), g_image, sizeof(g_image));
+        {
+            split_t ps(g_sim, cold, 4, hot, 8);
+
+            CHECK(ps.Load(c));
+            memcpy(c.serial, "SERIAL-B", 8);
+            c.hot.run_hours = 3;
+            g_sim.CutAfter(static_cast<int32_t>(n));
+            done = ps.Save(c);
+            g_sim.Restore();
+        }
+        {
+            split_t ps(g_sim, cold, 4, hot, 8);
+
+            CHECK(ps.Load(l));
+            CHECK(l.hot.run_hours == 2 || l.hot.run_hours == 3);
+            CHECK(!memcmp(l.serial, "SERIAL-A", 8) || (!memcmp(l.serial, "SERIAL-B", 8) && l.hot.run_hours == 3));
+            CHECK(!done || (!memcmp(l.serial, "SERIAL-B", 8) && l.hot.run_hours == 3));
+        }
+    }
+    std::cout << "cut points  = " << n << std::endl;
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
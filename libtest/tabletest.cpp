@@ -0,0 +1,174 @@
+/**
+ * \file
+ * Test of persistent table, records relocated as pages are reused so records never changed survive,
+ * lookup after reboot and power cut during commit.  Build with any C++ compiler,
+ * e.g. "g++ -I.. tabletest.cpp"
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: host (win32, linux)
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Software CRC32
+#define ARDUINO_ARCH_STM32
+
+#include "../media.h"
+#include "../table.h"
+#include "flashsim.h"
+
+#define CHECK(c)        if (!(c)) { std::cerr << "ERROR: line " << __LINE__ << ": " #c << std::endl; return 1; }
+
+#define RECORDS         16
+
+typedef struct {
+    int32_t     gain;
+    int16_t     offset;
+    uint16_t    ch;
+}cal_t;
+
+typedef persist::Table<cal_t, RECORDS> table_t;
+
+FlashSim<128, 6> g_sim;
+cal_t g_ref[RECORDS], g_image_ref[RECORDS];
+uint8_t g_image[128 * 6];
+
+
+/**
+ * Reload table and compare every record with reference
+ *
+ * \return true all present and same
+ */
+static bool Same() {
+    table_t t(g_sim, g_sim.GetStart(), 6);
+    bool ok = t.Load();
+
+    for(uint16_t i = 0; ok && i < RECORDS; i++) {
+        ok = t.IsPresent(i) && !t.IsDirty(i) && !memcmp(&t.Get(i), &g_ref[i], sizeof(cal_t));
+    }
+
+    return ok;
+}
+
+
+int main() {
+    uint32_t i, n, erases;
+    uint16_t k;
+    bool done;
+
+    memset(g_ref, 0, sizeof(g_ref));
+    {
+        table_t t(g_sim, g_sim.GetStart(), 6);
+
+        CHECK(t.Load() && t.GetEntriesPerPage() == 7);
+        for(k = 0; k < RECORDS; k++) {
+            CHECK(!t.IsPresent(k));
+            g_ref[k].ch = k;
+            g_ref[k].gain = 1000 + k;
+            CHECK(t.Set(k, g_ref[k]) && t.IsDirty(k));
+        }
+        CHECK(!t.Set(RECORDS, g_ref[0]));
+        CHECK(t.Commit());
+    }
+    CHECK(Same());
+
+    // Only record 3 changes, ring wraps many times relocating the others ahead of each erase
+    g_sim.Clear();
+    {
+        table_t t(g_sim, g_sim.GetStart(), 6);
+
+        CHECK(t.Load());
+        for(i = 0; i < 200; i++) {
+            g_ref[3].gain++;
+            CHECK(t.Set(3, g_ref[3]) && t.Commit());
+            if (!(i % 7)) {
+                CHECK(Same());
+            }
+        }
+        CHECK(!memcmp(&t.Get(0), &g_ref[0], sizeof(cal_t)));
+    }
+    erases = g_sim.GetErases();
+    CHECK(erases > 6 && erases < 200);
+    CHECK(Same());
+
+    // Unchanged record not written again
+    {
+        table_t t(g_sim, g_sim.GetStart(), 6);
+
+        CHECK(t.Load());
+        g_sim.Clear();
+        CHECK(t.Set(5, g_ref[5]) && !t.IsDirty(5) && t.Commit());
+        CHECK(g_sim.GetWrites() == 0);
+    }
+
+    // Power cut at each point of commits of two records, head moving through page changes and
+    // relocation.  Each old or new and the rest intact
+    for(n = 0; n < 60; n++) {
+        cal_t a = g_ref[7], b = g_ref[12];
+        {
+            table_t t(g_sim, g_sim.GetStart(), 6);
+
+            CHECK(t.Load());
+            a.offset++;
+            b.offset--;
+            t.Set(7, a);
+            t.Set(12, b);
+            g_sim.CutAfter(static_cast<int32_t>(n % 6));
+            done = t.Commit();
+            g_sim.Restore();
+        }
+        {
+            table_t t(g_sim, g_sim.GetStart(), 6);
+
+            CHECK(t.Load());
+            CHECK(!memcmp(&t.Get(7), &a, sizeof(cal_t)) || !memcmp(&t.Get(7), &g_ref[7], sizeof(cal_t)));
+            CHECK(!memcmp(&t.Get(12), &b, sizeof(cal_t)) || !memcmp(&t.Get(12), &g_ref[12], sizeof(cal_t)));
+            CHECK(!done || (!memcmp(&t.Get(7), &a, sizeof(cal_t)) && !memcmp(&t.Get(12), &b, sizeof(cal_t))));
+            g_ref[7] = t.Get(7);
+            g_ref[12] = t.Get(12);
+        }
+        CHECK(Same());
+    }
+
+    // One failed write or erase at each point of a run of commits, then reboot.  Relocation left
+    // incomplete by the failure is resumed, every later commit succeeds
+    memcpy(g_image, g_sim.GetMemory(), sizeof(g_image));
+    memcpy(g_image_ref, g_ref, sizeof(g_ref));
+    for(n = 0; n < 400; n++) {
+        memcpy(g_sim.GetMemory(), g_image, sizeof(g_image));
+        memcpy(g_ref, g_image_ref, sizeof(g_ref));
+        {
+            table_t t(g_sim, g_sim.GetStart(), 6);
+
+            CHECK(t.Load());
+            g_sim.FailAfter(static_cast<int32_t>(n));
+            for(i = 0; i < 60; i++) {
+                k = static_cast<uint16_t>((i % 8) ? 3 : (i * 5) % RECORDS);
+                g_ref[k].gain++;
+                t.Set(k, g_ref[k]);
+                t.Commit();
+            }
+            g_sim.Restore();
+        }
+        {
+            table_t t(g_sim, g_sim.GetStart(), 6);
+
+            CHECK(t.Load());
+            for(i = 0; i < RECORDS; i++) {
+                g_ref[i] = t.Get(static_cast<uint16_t>(i));
+            }
+            for(i = 0; i < 50; i++) {
+                k = static_cast<uint16_t>((i * 3) % RECORDS);
+                g_ref[k].offset++;
+                CHECK(t.Set(k, g_ref[k]) && t.Commit());
+            }
+        }
+        CHECK(Same());
+    }
+
+    std::cout << "PASS" << std::endl;
+
+    return 0;
+} // main()
@@ -0,0 +1,535 @@
+/**
+ * \file
+ * Persistent append only log of fixed size entries with wear levelling
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTLOG_H
+#define PERSISTLOG_H
+
+#include "media.h"
+
+
+namespace persist {
+
+/**
+ * A class offering persistent storage of a sequence of user supplied structures (samples, events).  Many
+ * entries are packed into each media page and pages are used as a ring, the oldest page being erased
+ * when the ring is full.  Appending an entry writes just that entry (no erase) via \ref Media::Write.
+ *
+ * Page layout, each entry is protected by its own check word:
+ *
+ * \code
+ * [sequence][~sequence] [check][T] [check][T] ... [check][T]
+ * \endcode
+ *
+ * On \ref Load the newest page is found from page sequence headers and the write position within it
+ * by binary search, after that \ref Append is O(1).
+ *
+ * \code
+ * persist::Log<sample_t> g_samples(g_media, start, 8);
+ *
+ * g_samples.Append(s);
+ * for(persist::Log<sample_t>::Iterator it(g_samples); it.IsValid(); it.Next()) {
+ *     if (it.Get(s)) { ... }
+ * }
+ * \endcode
+ *
+ * \note Media must support \ref Media::Write and \ref Media::Erase and erase state 0xffffffff
+ * \note Between (pages - 1) and pages times \ref GetEntriesPerPage entries are retained
+ *
+ * \tparam T ADT type name of a log entry
+ */
+template<typename T>
+class Log {
+public:
+#pragma pack(push, 4) // Optimised for ARM
+    /**
+     * Log entry raw storage format written to media
+     */
+    struct tEntry {
+        uint32_t check;
+        union {
+            T        data;
+            uint32_t u32[(sizeof(T) / sizeof(uint32_t)) + ((sizeof(T) % sizeof(uint32_t)) ? 1 : 0)];
+        };
+    };
+#pragma pack(pop)
+
+    /**
+     * Iterator over entries retained in log, from oldest to newest.  Becomes stale on \ref Append
+     */
+    class Iterator {
+    public:
+        /**
+         * Constructor, positioned on oldest or newest entry
+         *
+         * \param[in] log instance reference, must be loaded
+         * \param[in] newest default false.  Position on newest entry when true
+         */
+        Iterator(Log &log, const bool newest=false) : log_(log), valid_(log.GetCount() != 0) {
+            if (newest) {
+                page_ = log_.head_page_;
+                index_ = log_.head_index_;
+                if (!index_) {
+                    // Head page opened but empty
+                    page_ = log_.GetPreviousPage(page_);
+                    index_ = log_.per_page_;
+                }
+                index_--;
+            }else {
+                page_ = log_.GetTailPage();
+                index_ = 0;
+            }
+        } // Iterator(...)
+
+
+        /**
+         * Query, is iterator positioned on an entry
+         *
+         * \retval true positioned
+         * \retval false moved beyond either end
+         */
+        bool IsValid() const {
+            return valid_;
+        } // IsValid()
+
+
+        /**
+         * Move to next (newer) entry
+         *
+         * \retval true moved
+         * \retval false no newer entry
+         */
+        bool Next() {
+            if (valid_) {
+                if (page_ == log_.head_page_) {
+                    valid_ = (index_ + 1) < log_.head_index_;
+                    if (valid_) {
+                        index_++;
+                    }
+                }else if ((index_ + 1) < log_.per_page_) {
+                    index_++;
+                }else {
+                    page_ = log_.GetNextPage(page_);
+                    index_ = 0;
+                    valid_ = page_ != log_.head_page_ || log_.head_index_;
+                }
+            }
+
+            return valid_;
+        } // Next()
+
+
+        /**
+         * Move to previous (older) entry
+         *
+         * \retval true moved
+         * \retval false no older entry
+         */
+        bool Previous() {
+            if (valid_) {
+                if (index_) {
+                    index_--;
+                }else if (page_ == log_.GetTailPage()) {
+                    valid_ = false;
+                }else {
+                    page_ = log_.GetPreviousPage(page_);
+                    index_ = static_cast<uint16_t>(log_.per_page_ - 1);
+                }
+            }
+
+            return valid_;
+        } // Previous()
+
+
+        /**
+         * Read entry at iterator position
+         *
+         * \param[out] data entry ADT
+         * \retval true read and check word matches
+         * \retval false not positioned, read failure or entry damaged (power loss during append)
+         */
+        bool Get(T &data) const {
+            return valid_ && log_.Read(page_, index_, data);
+        } // Get(...)
+
+    /*! \cond PRIVATE */
+    protected:
+        Log         &log_;
+        uint16_t    page_;
+        uint16_t    index_;
+        bool        valid_;
+    /*! \endcond */
+    }; // class Iterator
+
+
+    /**
+     * Constructor based upon page count. You will have to load via \ref Load or first \ref Append
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] pages N count, minimum 2
+     */
+    Log(Media &m, uint32_t *start, uint16_t pages) : media_(m), start_(start), pages_(pages) {
+        Init();
+    } // Log(...)
+
+
+    /**
+     * Constructor based upon start and end pointers covering range for storage. You will have to
+     * load via \ref Load or first \ref Append
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] end location or offset into media.  Numeric may not represent a valid CPU address.
+     * Should be > start.
+     */
+    Log(Media &m, uint32_t *start, uint32_t *end) : media_(m), start_(start) {
+        pages_ = static_cast<uint16_t>(static_cast<uint32_t>(end - start) / (m.GetPageSize()>>2));
+        Init();
+    } // Log(...)
+
+
+    /**
+     * Load log state from media.  Finds the newest page from page headers and the write position
+     * within it by binary search of entry check words.  No entry data is read.
+     *
+     * \retval true loaded, log may be empty
+     * \retval false log doesn't fit media pages
+     */
+    bool Load() {
+        uint32_t h[HEAD_U32];
+        uint32_t s = 0, t = 0;
+        uint16_t p;
+
+        loaded_ = false;
+        used_ = 0;
+        head_page_ = static_cast<uint16_t>(pages_ - 1);    // Next page opened is first
+        head_index_ = per_page_;
+
+        if (pages_ > 1 && per_page_) {
+            // Newest (largest sequence) and oldest pages
+            for(p = 0; p < pages_; p++) {
+                if (ReadPageHeader(p, h)) {
+                    if (!used_ || h[0] > s) {
+                        s = h[0];
+                        head_page_ = p;
+                    }
+                    if (!used_ || h[0] < t) {
+                        t = h[0];
+                    }
+                    used_ = 1;
+                }
+            }
+
+            if (used_) {
+                sequence_ = s;
+                used_ = static_cast<uint16_t>(s - t + 1);
+                if (used_ > pages_) {
+                    used_ = pages_;
+                }
+
+                // Entries are appended in order, find first erased check word
+                head_index_ = FindCheck(head_page_, per_page_, media_.GetEraseState(), true);
+            }
+            loaded_ = true;
+        }
+
+        return loaded_;
+    } // Load()
+
+
+    /**
+     * Append entry to log.  Only the entry is written unless a new page is required, in which case
+     * the oldest page is erased once the ring is full
+     *
+     * \param[in] data entry ADT
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Append(const T &data) {
+        uint8_t i;
+        bool done = false;
+
+        if (loaded_ || Load()) {
+            // Write attempt loop, a failed slot is skipped once zeroed
+            for(i = 0; !done && i < 2; i++) {
+                if (!used_ || head_index_ >= per_page_) {
+                    if (!OpenPage()) {
+                        break;
+                    }
+                }
+                done = Put(data);
+            }
+        }
+
+        return done;
+    } // Append(...)
+
+
+    /**
+     * Erase all log pages
+     *
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Clear() {
+        bool done = media_.Erase(start_, pages_);
+
+        Load();
+
+        return done;
+    } // Clear()
+
+
+    /**
+     * Get count of entries retained, including any damaged ones
+     *
+     * \return N
+     */
+    uint32_t GetCount() const {
+        uint32_t n = 0;
+
+        if (loaded_ && used_) {
+            n = static_cast<uint32_t>(used_ - 1) * per_page_ + head_index_;
+        }
+
+        return n;
+    } // GetCount()
+
+
+    /**
+     * Get count of entries stored per media page
+     *
+     * \return N
+     */
+    uint16_t GetEntriesPerPage() const {
+        return per_page_;
+    } // GetEntriesPerPage()
+
+
+    /**
+     * Get entry storage size, includes check word
+     *
+     * \return Size, Bytes
+     */
+    static constexpr uint32_t GetEntrySize() {
+        return sizeof(tEntry);
+    } // GetEntrySize()
+
+
+    /**
+     * Query log state been loaded from media
+     *
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool IsLoaded() const {
+        return loaded_;
+    } // IsLoaded()
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Page header and entry sizes, sizeof(uint32_t) multiples
+     */
+    enum {
+        HEAD_U32 = 2,
+        ENTRY_U32 = sizeof(tEntry) / sizeof(uint32_t)
+    };
+
+
+    /**
+     * Common constructor initialisation
+     */
+    void Init() {
+        page_u32_ = media_.GetPageSize()>>2;
+        per_page_ = static_cast<uint16_t>((page_u32_ > HEAD_U32) ? (page_u32_ - HEAD_U32) / ENTRY_U32 : 0);
+        sequence_ = 0;
+        used_ = 0;
+        head_page_ = 0;
+        head_index_ = 0;
+        loaded_ = false;
+    } // Init()
+
+
+    /**
+     * Calculate entry check word.  Never erase state (top bit clear) or zero
+     *
+     * \param[in] e entry
+     * \return Check word
+     */
+    uint32_t GetCheck(const tEntry &e) {
+        uint32_t c = media_.Crc(e.u32, sizeof(e.u32) / sizeof(uint32_t)) & 0x7fffffffUL;
+
+        return c ? c : 1;
+    } // GetCheck(...)
+
+
+    /**
+     * Read and check page header
+     *
+     * \param[in] page index
+     * \param[out] h header words
+     * \retval true page in use
+     * \retval false erased or damaged
+     */
+    bool ReadPageHeader(const uint16_t page, uint32_t *h) {
+        return media_.Read(GetPageLocation(page), h, HEAD_U32) && h[0] != media_.GetEraseState() && h[1] == ~h[0];
+    } // ReadPageHeader(...)
+
+
+    /**
+     * Binary search page for first entry where check word equality with given word is as required.
+     * Entries must be ordered so that the equality changes once only.
+     *
+     * \param[in] page index
+     * \param[in] n count of entries to search
+     * \param[in] word check word to compare
+     * \param[in] equal required equality
+     * \return Entry index, n when none found
+     */
+    uint16_t FindCheck(const uint16_t page, const uint16_t n, const uint32_t word, const bool equal) {
+        uint32_t c;
+        uint16_t lo = 0, hi = n, mid;
+
+        while(lo < hi) {
+            mid = static_cast<uint16_t>((lo + hi) >> 1);
+            if (media_.Read(GetEntryLocation(page, mid), &c, 1) && (c == word) == equal) {
+                hi = mid;
+            }else {
+                lo = static_cast<uint16_t>(mid + 1);
+            }
+        }
+
+        return lo;
+    } // FindCheck(...)
+
+
+    /**
+     * Open next page for append.  Page is erased (oldest page reclaimed when ring full) and a new
+     * sequence header written
+     *
+     * \retval true opened
+     * \retval false erase or write failed
+     */
+    bool OpenPage() {
+        uint16_t p = GetNextPage(head_page_);
+        uint32_t *l = GetPageLocation(p);
+        uint32_t h[HEAD_U32];
+        bool done;
+
+        h[0] = used_ ? sequence_ + 1 : 0;
+        h[1] = ~h[0];
+        done = media_.Erase(l, 1) && media_.Write(l, h, HEAD_U32);
+        if (done) {
+            sequence_ = h[0];
+            head_page_ = p;
+            head_index_ = 0;
+            if (used_ < pages_) {
+                used_++;
+            }
+        }
+
+        return done;
+    } // OpenPage()
+
+
+    /**
+     * Write entry at head of log.  Head page must have room.  When the write fails the check word is
+     * zeroed, a damaged entry, and the slot skipped.  The slot is only kept when zeroing fails too,
+     * so the check words of a page stay erased from head on (see \ref FindCheck)
+     *
+     * \param[in] data entry ADT
+     * \retval true on success
+     * \retval false write failed
+     */
+    bool Put(const T &data) {
+        tEntry e;
+        uint32_t *l = GetEntryLocation(head_page_, head_index_);
+        uint32_t i, z = 0;
+        bool done;
+
+        for(i = 0; i < sizeof(e.u32) / sizeof(uint32_t); i++) {
+            e.u32[i] = media_.GetEraseState();
+        }
+        e.data = data;
+        e.check = GetCheck(e);
+
+        // Check word is written first
+        done = media_.Write(l, &e.check, ENTRY_U32);
+        if (done || media_.Write(l, &z, 1)) {
+            head_index_++;
+        }
+
+        return done;
+    } // Put(...)
+
+
+    /**
+     * Read and check entry
+     *
+     * \param[in] page index
+     * \param[in] index entry index within page
+     * \param[out] data entry ADT
+     * \retval true read and check word matches
+     * \retval false read failure or damaged
+     */
+    bool Read(const uint16_t page, const uint16_t index, T &data) {
+        tEntry e = {};
+        bool ok = media_.Read(GetEntryLocation(page, index), &e.check, ENTRY_U32) && e.check == GetCheck(e);
+
+        if (ok) {
+            data = e.data;
+        }
+
+        return ok;
+    } // Read(...)
+
+
+    uint16_t GetTailPage() const {
+        return static_cast<uint16_t>((head_page_ + pages_ + 1 - used_) % pages_);
+    } // GetTailPage()
+
+
+    uint16_t GetNextPage(const uint16_t page) const {
+        return static_cast<uint16_t>((page + 1) % pages_);
+    } // GetNextPage(...)
+
+
+    uint16_t GetPreviousPage(const uint16_t page) const {
+        return static_cast<uint16_t>((page + pages_ - 1) % pages_);
+    } // GetPreviousPage(...)
+
+
+    uint32_t* GetPageLocation(const uint16_t page) const {
+        return start_ + static_cast<uint32_t>(page) * page_u32_;
+    } // GetPageLocation(...)
+
+
+    uint32_t* GetEntryLocation(const uint16_t page, const uint16_t index) const {
+        return GetPageLocation(page) + HEAD_U32 + static_cast<uint32_t>(index) * ENTRY_U32;
+    } // GetEntryLocation(...)
+
+
+protected:
+    Media       &media_;
+    uint32_t    *start_;            // Location of first page
+    uint32_t    page_u32_;          // Media page size, sizeof(uint32_t) multiples
+    uint32_t    sequence_;          // Sequence of head page
+    uint16_t    pages_;             // Ring size
+    uint16_t    per_page_;          // Entries per page
+    uint16_t    used_;              // Pages in use, oldest to head
+    uint16_t    head_page_;         // Page of newest entry
+    uint16_t    head_index_;        // Next free entry in head page
+    bool        loaded_;
+/*! \endcond */
+}; // class Log
+
+} // namespace persist
+
+#endif // PERSISTLOG_H
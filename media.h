@@ -25,6 +25,17 @@ public:
     virtual uint32_t GetPageSize() const = 0;
 
 
+    /**
+     * Get media program page size.  Writes are split at program page boundaries by the wrapper, a media page
+     * (erase unit, see \ref GetPageSize) may hold several (external SPI NOR)
+     *
+     * \return Bytes, media page size unless overridden
+     */
+    virtual uint32_t GetProgramSize() const {
+        return GetPageSize();
+    } // GetProgramSize()
+
+
     /**
      * Get media storage size.  Based upon media internal start and end pointers
      * 
@@ -94,6 +105,94 @@ public:
      */            
     virtual uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) = 0;
 
+
+    /**
+     * Get CPU address of media location.  Only memory mapped media (like on-chip NOR flash
+     * on a 32bit device) can return a usable address, allowing data to be accessed directly
+     * without a copy via \ref Read.
+     *
+     * \param[in] buffer pointer to location on media
+     * \return Pointer usable by CPU or NULL when media not memory mapped
+     */
+    virtual const uint32_t* Map(const uint32_t *buffer) const {
+        (void)buffer;
+
+        return NULL;
+    } // Map(...)
+
+
+    /**
+     * Write media with given data without any erase.  Only bits in erase state can change, so a location
+     * is written once after erase.  Writing all zero bits to a written location (clearing it) is supported
+     * by NOR flash and EEPROM.  Used by append style storage to avoid a page erase per write.
+     *
+     * \note Implement media mutex or critical section within your own wrapper class if using
+     * an OS or tasker
+     *
+     * \param[in] buffer pointer to write location on media
+     * \param[in] data pointer to source data to write
+     * \param[in] size_u32 size of source data, sizeof(uint32_t) multiples
+     * \retval true on success
+     * \retval false on failure or media doesn't support write without erase
+     */
+    virtual bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        (void)buffer;
+        (void)data;
+        (void)size_u32;
+
+        return false;
+    } // Write(...)
+
+
+    /**
+     * Erase N pages from given location, leaving them in erase state (see \ref GetEraseState)
+     *
+     * \param[in] buffer pointer to page aligned location on media
+     * \param[in] pages N count for erase
+     * \retval true on success
+     * \retval false on failure or media doesn't support erase
+     */
+    virtual bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        (void)buffer;
+        (void)pages;
+
+        return false;
+    } // Erase(...)
+
+
+    /**
+     * Get media erase state of a word
+     *
+     * \return uint32_t numeric read from an erased location
+     */
+    virtual uint32_t GetEraseState() const {
+        return 0xffffffffUL;
+    } // GetEraseState()
+
+
+    /**
+     * Query, does media need erase before write.  Media without erase and with no practical wear
+     * (FRAM, MRAM) return false, \ref Struct then uses two slots alternately rather than a ring
+     *
+     * \retval true erase required (flash)
+     * \retval false written in place
+     */
+    virtual bool NeedsErase() const {
+        return true;
+    } // NeedsErase()
+
+
+    /**
+     * Get end location of firmware image on media, usually from linker symbols.  Used by \ref Region
+     * to give storage every free page after the image
+     *
+     * \return Pointer.  Numeric may not represent a valid CPU address.  NULL when not known (or no
+     * image on media)
+     */
+    virtual uint32_t* GetImageEnd() const {
+        return NULL;
+    } // GetImageEnd()
+
 }; // class Media
 
 } // namespace persist
@@ -0,0 +1,218 @@
+/**
+ * \file
+ * High endurance parameter ring for AVR on-chip EEPROM (Atmel AVR101)
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR
+ */
+
+#ifndef EERINGAVR_H
+#define EERINGAVR_H
+
+#if defined(ARDUINO_ARCH_AVR)
+
+#include <stdint.h>
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif // defined(__AVR__)
+
+
+namespace wrap {
+
+/**
+ * A class offering persistent storage of one parameter (user supplied structure) in AVR EEPROM using
+ * the AVR101 parameter and status buffer technique.  N copies of the parameter rotate, a status byte per
+ * copy marks the current one:
+ *
+ * \code
+ * [status 0] ... [status N-1] [param 0] ... [param N-1]
+ * \endcode
+ *
+ * A save writes the next parameter copy then its status byte, status counting on from the current one.
+ * The current copy is found where status stops counting.  EEPROM is Byte written so only Bytes that
+ * differ from the copy being replaced are written (eeprom_update_block), rather than the dword update
+ * and read back per word of \ref Ee with a slot rotation.  Reads are block reads.  Use an instance per
+ * parameter so each rotates independently.
+ *
+ * \code
+ * wrap::EeRing<cal_t, 8> g_cal(0);
+ *
+ * if (!g_cal.Load(cal)) { ... }
+ * cal.offset = 3;
+ * g_cal.Save(cal);
+ * \endcode
+ *
+ * Endurance is N times that of one location.  Power loss during a save leaves the previous copy current.
+ *
+ * \note No CRC is kept, a save interrupted while writing the status byte may leave a copy not found
+ * \tparam T ADT type name of parameter
+ * \tparam N copies, 2 to 254
+ */
+template<typename T, uint8_t N>
+class EeRing {
+public:
+    /**
+     * Constructor. You will have to load via \ref Load or \ref Save
+     *
+     * \param[in] address EEPROM byte address of ring, \ref GetSize Bytes used
+     */
+    EeRing(const uint16_t address) : address_(address), index_(0), status_(STATUS_ERASED), loaded_(false) {
+    } // EeRing(...)
+
+
+    /**
+     * Load current copy.  Status buffer is scanned once, later loads read only the copy
+     *
+     * \param[out] data parameter
+     * \retval true loaded
+     * \retval false never saved
+     */
+    bool Load(T &data) {
+        bool ok = (loaded_ || Find()) && status_ != STATUS_ERASED;
+
+        if (ok) {
+            eeprom_read_block(&data, GetParameter(index_), sizeof(T));
+        }
+
+        return ok;
+    } // Load(...)
+
+
+    /**
+     * Save parameter to next copy.  Nothing is written when parameter is unchanged
+     *
+     * \param[in] data parameter
+     * \retval true on success
+     * \retval false verify failed, previous copy remains current
+     */
+    bool Save(const T &data) {
+        T t;
+        uint8_t i = 0, s = 0;
+        bool done;
+
+        if (!loaded_) {
+            Find();
+        }
+
+        // Unchanged?
+        done = status_ != STATUS_ERASED && Load(t) && IsSame(t, data);
+        if (!done) {
+            if (status_ != STATUS_ERASED) {
+                i = static_cast<uint8_t>((index_ + 1) % N);
+                s = GetNextStatus(status_);
+            }
+
+            // Parameter then status, only changed Bytes are written
+            eeprom_update_block(&data, GetParameter(i), sizeof(T));
+            eeprom_read_block(&t, GetParameter(i), sizeof(T));
+            done = IsSame(t, data);
+            if (done) {
+                eeprom_update_byte(GetStatus(i), s);
+                done = eeprom_read_byte(GetStatus(i)) == s;
+            }
+            if (done) {
+                index_ = i;
+                status_ = s;
+            }
+        }
+
+        return done;
+    } // Save(...)
+
+
+    /**
+     * Get current copy index
+     *
+     * \note Use as debugging aid
+     *
+     * \return N
+     */
+    uint8_t GetIndex() const {
+        return index_;
+    } // GetIndex()
+
+
+    /**
+     * Get EEPROM size used
+     *
+     * \return Bytes
+     */
+    static constexpr uint16_t GetSize() {
+        return N + N * sizeof(T);
+    } // GetSize()
+
+/*! \cond PRIVATE */
+protected:
+    enum {
+        STATUS_ERASED = 0xff        // Never written, status counts 0 to 0xfe
+    };
+
+
+    static uint8_t GetNextStatus(const uint8_t s) {
+        return (s >= STATUS_ERASED - 1) ? 0 : static_cast<uint8_t>(s + 1);
+    } // GetNextStatus(...)
+
+
+    uint8_t* GetStatus(const uint8_t i) const {
+        return reinterpret_cast<uint8_t*>(address_ + i);
+    } // GetStatus(...)
+
+
+    T* GetParameter(const uint8_t i) const {
+        return reinterpret_cast<T*>(address_ + N + static_cast<uint16_t>(i) * sizeof(T));
+    } // GetParameter(...)
+
+
+    static bool IsSame(const T &a, const T &b) {
+        const uint8_t *x = reinterpret_cast<const uint8_t*>(&a);
+        const uint8_t *y = reinterpret_cast<const uint8_t*>(&b);
+        uint16_t i;
+
+        for(i = 0; i < sizeof(T) && x[i] == y[i]; i++);
+
+        return i == sizeof(T);
+    } // IsSame(...)
+
+
+    /**
+     * Find current copy, last status before the count breaks.  First status erased is an empty ring
+     *
+     * \return true always
+     */
+    bool Find() {
+        uint8_t b[16], i, n, s;
+
+        eeprom_read_block(b, GetStatus(0), 1);
+        index_ = 0;
+        status_ = b[0];
+        if (status_ != STATUS_ERASED) {
+            for(i = 1; i < N; i+= n) {
+                n = static_cast<uint8_t>((N - i > static_cast<int>(sizeof(b))) ? sizeof(b) : N - i);
+                eeprom_read_block(b, GetStatus(i), n);
+                for(s = 0; s < n && b[s] == GetNextStatus(status_); s++) {
+                    index_++;
+                    status_ = b[s];
+                }
+                if (s < n) {
+                    break;
+                }
+            }
+        }
+        loaded_ = true;
+
+        return loaded_;
+    } // Find()
+
+
+protected:
+    uint16_t    address_;
+    uint8_t     index_;             // Current copy
+    uint8_t     status_;            // Status of current copy
+    bool        loaded_;
+/*! \endcond */
+}; // class EeRing
+
+} // namespace wrap
+
+#endif // ARDUINO_ARCH_AVR
+
+#endif // EERINGAVR_H
@@ -232,7 +232,9 @@ public:
         uint16_t s = size_u8>>1, ps;
 
         for(;s>0;) {
-            for(pb = b, ps = page_size_u8/sizeof(uint16_t);ps>0; s--, d++, b++, ps--) {
+            // Fill to end of page, buffer may start part way into a page
+            ps = static_cast<uint16_t>((page_size_u8 - (reinterpret_cast<optiboot_addr_t>(b) % page_size_u8))/sizeof(uint16_t));
+            for(pb = b;ps>0; s--, d++, b++, ps--) {
                 if (!s) {
                     break;    // final page, end of data
                 }
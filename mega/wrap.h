@@ -11,11 +11,17 @@
 #if defined(ARDUINO_ARCH_AVR)
 
 #include "media.h"                // nPersist base
+#include "hint.h"
 
 // these are what we are wrapping...
 #include "mega/flash.h"
 #include "sw/crc.h"
 
+/*! \cond PRIVATE */
+// avr-libc linker script symbol, initialised data is loaded from flash after code
+extern "C" char __data_load_end;
+/*! \endcond */
+
 
 namespace wrap {
 
@@ -73,12 +79,65 @@ public:
         return true;
     } // Read(...)
 
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        // EEPROM has no erase constraint
+        return Program(buffer, data, size_u32, 0, false);
+    } // Write(...)
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        const uint32_t e = 0xffffffffUL;
+        uint32_t *b = const_cast<uint32_t*>(buffer);
+        uint32_t l = pages * (PSZ>>2), i;
+
+        for(i=0; i<l; i++) {
+            eeprom_update_dword(&b[i], e);
+        }
+
+        return true;
+    } // Erase(...)
+
     uint32_t Crc(const uint32_t *buffer, const uint16_t size_u16) {
         return swimp::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
     }
 }; // class Ee
 
 
+/**
+ * Slot location hint store in 4 Bytes of AVR EEPROM, for use with flash media.  Slot and its inverse
+ * are stored so an unwritten or damaged hint is detected
+ */
+class EeHint : public persist::Hint {
+public:
+    /**
+     * Constructor
+     *
+     * \param[in] address EEPROM byte address of hint, must not overlap EEPROM used otherwise
+     */
+    EeHint(const uint16_t address) : address_(address) {
+    }
+
+    bool Get(uint16_t &slot) {
+        uint32_t v = eeprom_read_dword(reinterpret_cast<uint32_t*>(address_));
+
+        slot = static_cast<uint16_t>(v);
+
+        return static_cast<uint16_t>(v >> 16) == static_cast<uint16_t>(~slot);
+    } // Get(...)
+
+    bool Set(const uint16_t slot) {
+        uint32_t v = static_cast<uint32_t>(slot) | (static_cast<uint32_t>(static_cast<uint16_t>(~slot)) << 16);
+
+        // Only changed bytes written
+        eeprom_update_dword(reinterpret_cast<uint32_t*>(address_), v);
+
+        return eeprom_read_dword(reinterpret_cast<uint32_t*>(address_)) == v;
+    } // Set(...)
+
+protected:
+    uint16_t address_;
+}; // class EeHint
+
+
 /**
  * Wrapper for MCU specialised API to flash module and CRC.  Each media type 
  * requires a different wrapper
@@ -112,9 +171,38 @@ class Flash : public persist::Media, protected swimp::Crc {
                                             reinterpret_cast<uint16_t*>(const_cast<uint32_t*>(data)), sizeu32*sizeof(uint32_t));
         }
         
+        bool Write(const uint32_t* buffer, const uint32_t* data, const int16_t size_u32) {
+            uint8_t sreg = SREG;
+            bool done;
+
+            cli();
+            done = avr8mega::Flash::Write16Buffer(reinterpret_cast<uint16_t*>(const_cast<uint32_t*>(buffer)), \
+                                            reinterpret_cast<uint16_t*>(const_cast<uint32_t*>(data)), size_u32*sizeof(uint32_t));
+            SREG = sreg;
+
+            return done;
+        }
+
+        bool Erase(const uint32_t* buffer, const uint32_t pages) {
+            uint8_t sreg = SREG;
+            bool done;
+
+            cli();
+            done = avr8mega::Flash::ErasePages(reinterpret_cast<uint16_t*>(const_cast<uint32_t*>(buffer)), \
+                                            static_cast<uint16_t>(pages), SPM_PAGESIZE);
+            SREG = sreg;
+
+            return done;
+        }
+
         uint32_t Crc(const uint32_t *buffer, const uint16_t length_u32) {
             return swimp::Crc::Generate(buffer, static_cast<uint32_t>(length_u32));
         }
+
+        uint32_t* GetImageEnd() const {
+            // avr-libc linker script, flash byte address of initialised data end.  First 64KB only
+            return reinterpret_cast<uint32_t *>(&__data_load_end);
+        }
 }; // class Flash
 } // namespace wrap
 
@@ -0,0 +1,336 @@
+/**
+ * \file
+ * Persistent structure stored in a dense bit packed form described by compile time field descriptors
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTPACK_H
+#define PERSISTPACK_H
+
+#include "struct.h"
+
+
+namespace persist {
+
+/*! \cond PRIVATE */
+/**
+ * Bit field helpers for packed byte buffers, LSB first
+ */
+struct PackBits {
+    /**
+     * Write value to buffer at bit position
+     *
+     * \param[in,out] buffer destination byte buffer
+     * \param[in] pos bit position
+     * \param[in] bits value width, 1 to 32
+     * \param[in] v value, only lower bits used
+     */
+    static void Put(uint8_t *buffer, uint32_t pos, uint8_t bits, uint32_t v) {
+        uint8_t o, n, mask;
+
+        while(bits) {
+            o = static_cast<uint8_t>(pos & 7);
+            n = static_cast<uint8_t>(8 - o);
+            if (n > bits) {
+                n = bits;
+            }
+            mask = static_cast<uint8_t>(((1U << n) - 1) << o);
+            buffer[pos>>3] = static_cast<uint8_t>((buffer[pos>>3] & ~mask) | ((v << o) & mask));
+            v>>= n;
+            pos+= n;
+            bits-= n;
+        }
+    } // Put(...)
+
+
+    /**
+     * Read value from buffer at bit position
+     *
+     * \param[in] buffer source byte buffer
+     * \param[in] pos bit position
+     * \param[in] bits value width, 1 to 32
+     * \return Value
+     */
+    static uint32_t Get(const uint8_t *buffer, uint32_t pos, uint8_t bits) {
+        uint32_t v = 0;
+        uint8_t o, n, s = 0;
+
+        while(bits) {
+            o = static_cast<uint8_t>(pos & 7);
+            n = static_cast<uint8_t>(8 - o);
+            if (n > bits) {
+                n = bits;
+            }
+            v|= static_cast<uint32_t>((buffer[pos>>3] >> o) & ((1U << n) - 1)) << s;
+            s+= n;
+            pos+= n;
+            bits-= n;
+        }
+
+        return v;
+    } // Get(...)
+
+
+    /**
+     * Offset value by range minimum and saturate to field width
+     *
+     * \param[in] v value
+     * \param[in] min range minimum
+     * \param[in] bits field width
+     * \return Stored value
+     */
+    static uint32_t ToStored(const int64_t v, const int32_t min, const uint8_t bits) {
+        int64_t s = v - min;
+        int64_t top = (bits < 32) ? ((static_cast<int64_t>(1) << bits) - 1) : 0xffffffffLL;
+
+        if (s < 0) {
+            s = 0;
+        }else if (s > top) {
+            s = top;
+        }
+
+        return static_cast<uint32_t>(s);
+    } // ToStored(...)
+}; // struct PackBits
+/*! \endcond */
+
+
+/**
+ * Field descriptor list terminator
+ */
+struct PackEnd {
+    enum { bits = 0 };
+
+    template<typename T>
+    static void Encode(const T &t, uint8_t *buffer, const uint32_t pos) {
+        (void)t; (void)buffer; (void)pos;
+    }
+
+    template<typename T>
+    static void Decode(T &t, const uint8_t *buffer, const uint32_t pos) {
+        (void)t; (void)buffer; (void)pos;
+    }
+}; // struct PackEnd
+
+
+/**
+ * Field descriptor for an integral (or bool/enum) member of ADT.  Values are stored as offset from
+ * range minimum MIN in BITS bits.  Out of range values saturate to the range limits.
+ * Descriptors are chained through NEXT, ending with \ref PackEnd.  MIN must be given when NEXT is.
+ *
+ * \tparam T ADT type name
+ * \tparam F member type
+ * \tparam M pointer to member of ADT &lt;T&gt;
+ * \tparam BITS stored width, 1 to 32
+ * \tparam MIN range minimum, default 0
+ * \tparam NEXT next descriptor, default \ref PackEnd
+ */
+template<typename T, typename F, F T::*M, uint8_t BITS, int32_t MIN = 0, typename NEXT = PackEnd>
+struct PackField {
+    enum { bits = BITS + NEXT::bits };
+
+    static void Encode(const T &t, uint8_t *buffer, const uint32_t pos) {
+        PackBits::Put(buffer, pos, BITS, PackBits::ToStored(static_cast<int64_t>(t.*M), MIN, BITS));
+        NEXT::Encode(t, buffer, pos + BITS);
+    } // Encode(...)
+
+    static void Decode(T &t, const uint8_t *buffer, const uint32_t pos) {
+        t.*M = static_cast<F>(static_cast<int64_t>(PackBits::Get(buffer, pos, BITS)) + MIN);
+        NEXT::Decode(t, buffer, pos + BITS);
+    } // Decode(...)
+}; // struct PackField
+
+
+/**
+ * Field descriptor for an integral array member of ADT, each element stored as \ref PackField
+ *
+ * \tparam T ADT type name
+ * \tparam E element type
+ * \tparam N element count
+ * \tparam M pointer to array member of ADT &lt;T&gt;
+ * \tparam BITS stored width of each element, 1 to 32
+ * \tparam MIN range minimum of each element, default 0
+ * \tparam NEXT next descriptor, default \ref PackEnd
+ */
+template<typename T, typename E, uint16_t N, E (T::*M)[N], uint8_t BITS, int32_t MIN = 0, typename NEXT = PackEnd>
+struct PackArray {
+    enum { bits = (BITS * N) + NEXT::bits };
+
+    static void Encode(const T &t, uint8_t *buffer, const uint32_t pos) {
+        for(uint16_t i = 0; i < N; i++) {
+            PackBits::Put(buffer, pos + i * BITS, BITS, PackBits::ToStored(static_cast<int64_t>((t.*M)[i]), MIN, BITS));
+        }
+        NEXT::Encode(t, buffer, pos + BITS * N);
+    } // Encode(...)
+
+    static void Decode(T &t, const uint8_t *buffer, const uint32_t pos) {
+        for(uint16_t i = 0; i < N; i++) {
+            (t.*M)[i] = static_cast<E>(static_cast<int64_t>(PackBits::Get(buffer, pos + i * BITS, BITS)) + MIN);
+        }
+        NEXT::Decode(t, buffer, pos + BITS * N);
+    } // Decode(...)
+}; // struct PackArray
+
+
+/**
+ * A class offering persistent storage access to a user supplied structure stored bit packed.  Compiler
+ * padding and unused value ranges are removed using a compile time field descriptor list, so each stored
+ * copy is smaller and more ware levels fit the same media.  Packing is done on \ref Save and unpacking
+ * on \ref Load.
+ *
+ * \code
+ * typedef persist::PackField<cfg_t, uint8_t,  &cfg_t::mode,   3, 0,
+ *         persist::PackField<cfg_t, int16_t,  &cfg_t::offset, 9, -256,
+ *         persist::PackArray<cfg_t, uint8_t, 6, &cfg_t::str,  7> > > cfg_schema_t;
+ *
+ * persist::Packed<cfg_t, cfg_schema_t> g_cfg_ps(g_media, g_media.GetStart(), 8);
+ * \endcode
+ *
+ * \note ADT members not described are not stored and left untouched by \ref Load
+ *
+ * \tparam T ADT type name
+ * \tparam SCHEMA field descriptor list, see \ref PackField and \ref PackArray
+ * \tparam H data block header policy, default \ref HeadStd.  \ref HeadCompact suits small records
+ */
+template<typename T, typename SCHEMA, typename H = HeadStd>
+class Packed {
+public:
+    /**
+     * Packed storage form of ADT
+     */
+    struct tPacked {
+        uint8_t b[(SCHEMA::bits + 7) / 8];
+    };
+
+    /**
+     * Constructor based upon required ware level. You will have to load your ADT via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start location or offset into media for first write.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] ware_level ware levels N (maximum)
+     */
+    Packed(Media &m, uint32_t *start, uint8_t ware_level) : ps_(m, start, ware_level) {
+    } // Packed(...)
+
+
+    /**
+     * Constructor based upon start and end pointers covering range for storage. You will have to
+     * load your ADT via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start location or offset into media for first write.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] end location or offset into media for first write.  Numeric may not represent
+     * a valid CPU address.  Should be > start.
+     */
+    Packed(Media &m, uint32_t *start, uint32_t *end) : ps_(m, start, end) {
+    } // Packed(...)
+
+
+    /**
+     * Load and unpack ADT from media
+     *
+     * \param[out] data block ADT.  Only described members are written
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool Load(T &data) {
+#if defined(PERSISTSTRUCT_POINTERS)
+        bool ok = ps_.Load();
+
+        if (ok) {
+            Decode(*ps_.Get(), data);
+        }
+#else // !PERSISTSTRUCT_POINTERS
+        tPacked p;
+        bool ok = ps_.Load(p);
+
+        if (ok) {
+            Decode(p, data);
+        }
+#endif // !PERSISTSTRUCT_POINTERS
+
+        return ok;
+    } // Load(...)
+
+
+    /**
+     * Pack and save ADT to media
+     *
+     * \param[in] data block ADT
+     * \param[in] not_loaded_force default false.  Required if not loaded to force save of given ADT to media
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Save(T &data, bool not_loaded_force=false) {
+#if defined(PERSISTSTRUCT_POINTERS)
+        Encode(data, *ps_.Get());
+
+        return ps_.Save(not_loaded_force);
+#else // !PERSISTSTRUCT_POINTERS
+        tPacked p;
+
+        Encode(data, p);
+
+        return ps_.Save(p, not_loaded_force);
+#endif // !PERSISTSTRUCT_POINTERS
+    } // Save(...)
+
+
+    /**
+     * Pack ADT
+     *
+     * \param[in] data block ADT
+     * \param[out] p packed form
+     */
+    static void Encode(const T &data, tPacked &p) {
+        for(uint32_t i = 0; i < sizeof(p.b); i++) {
+            p.b[i] = 0;
+        }
+        SCHEMA::Encode(data, p.b, 0);
+    } // Encode(...)
+
+
+    /**
+     * Unpack ADT
+     *
+     * \param[in] p packed form
+     * \param[out] data block ADT.  Only described members are written
+     */
+    static void Decode(const tPacked &p, T &data) {
+        SCHEMA::Decode(data, p.b, 0);
+    } // Decode(...)
+
+
+    /**
+     * Get internal data block packed storage size
+     *
+     * \return Size, Bytes
+     */
+    static constexpr uint32_t GetStorageUnitSize() {
+        return Struct<tPacked, H>::GetStorageUnitSize();
+    } // GetStorageUnitSize()
+
+
+    /**
+     * Get underlying persistent structure of packed form
+     *
+     * \note Use as debugging aid
+     *
+     * \return Reference
+     */
+    Struct<tPacked, H>& GetStruct() {
+        return ps_;
+    } // GetStruct()
+
+/*! \cond PRIVATE */
+protected:
+    Struct<tPacked, H>    ps_;
+/*! \endcond */
+}; // class Packed
+
+} // namespace persist
+
+#endif // PERSISTPACK_H
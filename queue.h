@@ -0,0 +1,276 @@
+/**
+ * \file
+ * Persistent FIFO queue of fixed size entries with wear levelling
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTQUEUE_H
+#define PERSISTQUEUE_H
+
+#include "log.h"
+
+
+namespace persist {
+
+/**
+ * A class offering a persistent first in first out queue of user supplied structures (messages waiting
+ * for an uplink).  Built upon \ref Log storage: \ref Push appends an entry and \ref Pop clears the entry
+ * check word to zero, a bit clearing write so no erase is required.  A page is erased once all of its
+ * entries have been consumed.  Each operation costs a write of the entry or a single word, independent
+ * of queue capacity.
+ *
+ * \code
+ * persist::Queue<msg_t> g_outbox(g_media, start, 4);
+ *
+ * g_outbox.Push(m);
+ * while(g_outbox.Peek(m) && Send(m)) {
+ *     g_outbox.Pop();
+ * }
+ * \endcode
+ *
+ * \note Power loss during \ref Pop may leave the entry queued, entries are delivered at least once
+ * \note Damaged entries (power loss during \ref Push) are consumed by \ref Peek
+ *
+ * \tparam T ADT type name of a queue entry
+ */
+template<typename T>
+class Queue : protected Log<T> {
+public:
+    /**
+     * Constructor based upon page count. You will have to load via \ref Load or first \ref Push
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] pages N count, minimum 2
+     */
+    Queue(Media &m, uint32_t *start, uint16_t pages) : Log<T>(m, start, pages), tail_index_(0) {
+    } // Queue(...)
+
+
+    /**
+     * Constructor based upon start and end pointers covering range for storage. You will have to
+     * load via \ref Load or first \ref Push
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] end location or offset into media.  Numeric may not represent a valid CPU address.
+     * Should be > start.
+     */
+    Queue(Media &m, uint32_t *start, uint32_t *end) : Log<T>(m, start, end), tail_index_(0) {
+    } // Queue(...)
+
+
+    /**
+     * Load queue state from media.  As \ref Log::Load and the first unconsumed entry of the oldest page
+     * is found by linear search, damaged entries (zeroed by a failed push) may follow it
+     *
+     * \retval true loaded, queue may be empty
+     * \retval false queue doesn't fit media pages
+     */
+    bool Load() {
+        bool ok = Log<T>::Load();
+
+        tail_index_ = 0;
+        if (ok && this->used_) {
+            tail_index_ = FindTail();
+            Reclaim();
+        }
+
+        return ok;
+    } // Load()
+
+
+    /**
+     * Push entry to back of queue.  As \ref Log::Append but a new page is only opened while the queue
+     * isn't full, also when retrying after a failed write, so unconsumed entries are never erased
+     *
+     * \param[in] data entry ADT
+     * \retval true on success
+     * \retval false failed or queue full
+     */
+    bool Push(const T &data) {
+        uint8_t i;
+        bool done = false;
+
+        if (this->loaded_ || Load()) {
+            // Write attempt loop, a failed slot is skipped once zeroed
+            for(i = 0; !done && i < 2; i++) {
+                if (!this->used_ || this->head_index_ >= this->per_page_) {
+                    // Next page still holds unconsumed entries?
+                    if (IsFull() || !this->OpenPage()) {
+                        break;
+                    }
+                }
+                done = this->Put(data);
+            }
+        }
+
+        return done;
+    } // Push(...)
+
+
+    /**
+     * Read entry at front of queue without removing it.  Damaged entries are consumed
+     *
+     * \param[out] data entry ADT
+     * \retval true read
+     * \retval false queue empty or consumed page erase failed
+     */
+    bool Peek(T &data) {
+        bool ok = false;
+
+        if ((this->loaded_ || Load()) && Reclaim()) {
+            while(!ok && GetCount()) {
+                ok = this->Read(this->GetTailPage(), tail_index_, data);
+                if (!ok && !Pop()) {
+                    break;
+                }
+            }
+        }
+
+        return ok;
+    } // Peek(...)
+
+
+    /**
+     * Remove entry from front of queue.  Entry check word is cleared and, when the last entry of
+     * a page, the page is erased.  Front of queue only moves once cleared
+     *
+     * \retval true on success
+     * \retval false queue empty, write or erase failed
+     */
+    bool Pop() {
+        const uint32_t z = 0;
+        bool done = false;
+
+        // Consumed page left by a failed erase reclaimed first
+        if ((this->loaded_ || Load()) && Reclaim() && GetCount()) {
+            done = this->media_.Write(this->GetEntryLocation(this->GetTailPage(), tail_index_), &z, 1);
+            if (done) {
+                tail_index_++;
+                done = Reclaim();
+            }
+        }
+
+        return done;
+    } // Pop()
+
+
+    /**
+     * Remove entry from front of queue, reading it first
+     *
+     * \param[out] data entry ADT
+     * \retval true read and removed
+     * \retval false queue empty or write failed
+     */
+    bool Pop(T &data) {
+        return Peek(data) && Pop();
+    } // Pop(...)
+
+
+    /**
+     * Erase all queue pages
+     *
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Clear() {
+        bool done = this->media_.Erase(this->start_, this->pages_);
+
+        Load();
+
+        return done;
+    } // Clear()
+
+
+    /**
+     * Get count of entries queued, including any damaged ones
+     *
+     * \return N
+     */
+    uint32_t GetCount() const {
+        uint32_t n = Log<T>::GetCount();
+
+        return (n > tail_index_) ? n - tail_index_ : 0;
+    } // GetCount()
+
+
+    /**
+     * Query, is queue full.  Back of queue has reached a page holding unconsumed entries
+     *
+     * \retval true full
+     * \retval false space for at least one entry
+     */
+    bool IsFull() const {
+        return this->used_ >= this->pages_ && this->head_index_ >= this->per_page_;
+    } // IsFull()
+
+
+    using Log<T>::IsLoaded;
+    using Log<T>::GetEntriesPerPage;
+    using Log<T>::GetEntrySize;
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Get count of entries written to page
+     *
+     * \param[in] page index
+     * \return N
+     */
+    uint16_t GetPageCount(const uint16_t page) const {
+        return (page == this->head_page_) ? this->head_index_ : this->per_page_;
+    } // GetPageCount(...)
+
+
+    /**
+     * Find first unconsumed entry of oldest page.  Entries before it have a zero check word
+     *
+     * \return Entry index
+     */
+    uint16_t FindTail() {
+        uint16_t n = GetPageCount(this->GetTailPage()), i;
+        uint32_t c;
+
+        for(i = 0; i < n; i++) {
+            if (!this->media_.Read(this->GetEntryLocation(this->GetTailPage(), i), &c, 1) || c) {
+                break;
+            }
+        }
+
+        return i;
+    } // FindTail()
+
+
+    /**
+     * Erase oldest page once all entries consumed.  Page is kept in use when erase fails
+     *
+     * \retval true nothing to do or erased
+     * \retval false erase failed
+     */
+    bool Reclaim() {
+        bool done = true;
+
+        if (this->used_ && tail_index_ >= this->per_page_) {
+            done = this->media_.Erase(this->GetPageLocation(this->GetTailPage()), 1);
+            if (done) {
+                this->used_--;
+                tail_index_ = 0;
+            }
+        }
+
+        return done;
+    } // Reclaim()
+
+
+protected:
+    uint16_t    tail_index_;        // Front of queue entry in oldest page
+/*! \endcond */
+}; // class Queue
+
+} // namespace persist
+
+#endif // PERSISTQUEUE_H
@@ -0,0 +1,189 @@
+/**
+ * \file
+ * Storage region sizing from free flash following the firmware image
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTREGION_H
+#define PERSISTREGION_H
+
+#include "media.h"
+
+
+namespace persist {
+
+/**
+ * A class offering a storage region covering every free page of on-chip flash after the firmware
+ * image, rather than a fixed page count at the top.  More pages give more ware levels and
+ * proportionally longer life.
+ *
+ * The image end is taken from \ref Media::GetImageEnd (linker symbols) or, when the wrapper doesn't
+ * provide it, found by scanning from media start for the first erased page.  Slots are counted down
+ * from media end so their locations never depend on the image size.  Headroom pages are left free
+ * after the image for firmware growth.
+ *
+ * Once written, the region start is found again on media: the first written slot within headroom of
+ * the image is taken as start.  A firmware update growing by no more than headroom leaves the start,
+ * and so every stored copy including the newest, in place.
+ *
+ * \code
+ * persist::Region g_region(g_media, persist::Struct<cfg_t>::GetStorageUnitSize(), 4);
+ * persist::Struct<cfg_t> g_cfg_ps(g_media, g_region.GetStart(), g_region.GetEnd());
+ * \endcode
+ *
+ * \attention Scanning assumes the image holds no erased page and needs headroom of at least 1 page, so an
+ * erased page always follows the image.  Provide \ref Media::GetImageEnd where this doesn't hold
+ * \note Use with program flash only.  Media without an image (EEPROM, external) start at \ref Media::GetStart
+ */
+class Region {
+public:
+    /**
+     * Constructor, region is found from media
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] slot_bytes storage unit size, see Struct::GetStorageUnitSize.  Rounded up to pages
+     * \param[in] headroom_pages default 0.  Pages left free after image for firmware growth
+     */
+    Region(Media &m, const uint32_t slot_bytes, const uint32_t headroom_pages=0) : media_(m) {
+        uint32_t page_u32 = media_.GetPageSize()>>2;
+
+        slot_u32_ = ((slot_bytes + media_.GetPageSize() - 1) / media_.GetPageSize()) * page_u32;
+        if (!slot_u32_) {
+            slot_u32_ = page_u32;
+        }
+        image_end_ = media_.GetImageEnd();
+        if (!image_end_) {
+            image_end_ = FindImageEnd();
+        }
+        start_ = FindStart(headroom_pages * page_u32);
+    } // Region(...)
+
+
+    /**
+     * Get region start, slot aligned from media end
+     *
+     * \return Pointer.  Numeric may not represent a valid CPU address
+     */
+    uint32_t* GetStart() const {
+        return start_;
+    } // GetStart()
+
+
+    /**
+     * Get region end, media end
+     *
+     * \return Pointer.  Numeric may not represent a valid CPU address
+     */
+    uint32_t* GetEnd() const {
+        return media_.GetEnd();
+    } // GetEnd()
+
+
+    /**
+     * Get slot count (ware levels) of region
+     *
+     * \note May exceed the 255 ware levels of Struct's ware level constructor, construct from
+     * \ref GetStart and \ref GetEnd instead
+     * \return N, 0 when no free flash
+     */
+    uint32_t GetSlots() const {
+        return static_cast<uint32_t>(media_.GetEnd() - start_) / slot_u32_;
+    } // GetSlots()
+
+
+    /**
+     * Get region page count
+     *
+     * \return N pages
+     */
+    uint32_t GetPages() const {
+        return static_cast<uint32_t>(media_.GetEnd() - start_) / (media_.GetPageSize()>>2);
+    } // GetPages()
+
+
+    /**
+     * Get firmware image end used
+     *
+     * \note Use as debugging aid
+     *
+     * \return Pointer.  Numeric may not represent a valid CPU address
+     */
+    uint32_t* GetImageEnd() const {
+        return image_end_;
+    } // GetImageEnd()
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Query, is page in erase state
+     *
+     * \param[in] page page aligned location
+     * \retval true erased
+     * \retval false written or read failure
+     */
+    bool IsErased(uint32_t *page) {
+        uint32_t buffer[8];
+        uint32_t page_u32 = media_.GetPageSize()>>2, i, j;
+        bool ok = true;
+
+        for(i = 0; ok && i < page_u32; i+= sizeof(buffer) / sizeof(uint32_t)) {
+            ok = media_.Read(page + i, buffer, sizeof(buffer) / sizeof(uint32_t));
+            for(j = 0; ok && j < sizeof(buffer) / sizeof(uint32_t); j++) {
+                ok = buffer[j] == media_.GetEraseState();
+            }
+        }
+
+        return ok;
+    } // IsErased(...)
+
+
+    /**
+     * Find image end, first erased page from media start
+     *
+     * \return Pointer, media end when none erased
+     */
+    uint32_t* FindImageEnd() {
+        uint32_t *l = media_.GetStart();
+
+        while(l < media_.GetEnd() && !IsErased(l)) {
+            l+= media_.GetPageSize()>>2;
+        }
+
+        return l;
+    } // FindImageEnd()
+
+
+    /**
+     * Find region start.  Lowest slot boundary above image end, then the first written slot within
+     * headroom of it (region in use) or the first slot boundary past headroom
+     *
+     * \param[in] headroom_u32 headroom, sizeof(uint32_t) multiples
+     * \return Pointer
+     */
+    uint32_t* FindStart(const uint32_t headroom_u32) {
+        uint32_t *e = media_.GetEnd();
+        uint32_t n = (image_end_ < e) ? static_cast<uint32_t>(e - image_end_) / slot_u32_ : 0;
+        uint32_t *l = e - n * slot_u32_;
+        uint32_t *h = l + headroom_u32;
+
+        // Written slot within headroom is region in use, keep it
+        while(l < h && l < e && IsErased(l)) {
+            l+= slot_u32_;
+        }
+
+        return (l < e) ? l : e;
+    } // FindStart(...)
+
+
+protected:
+    Media       &media_;
+    uint32_t    *image_end_;
+    uint32_t    *start_;
+    uint32_t    slot_u32_;          // Slot size, page multiples
+/*! \endcond */
+}; // class Region
+
+} // namespace persist
+
+#endif // PERSISTREGION_H
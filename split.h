@@ -0,0 +1,182 @@
+/**
+ * \file
+ * Persistent structure split into hot and cold parts, each with own wear levelling
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTSPLIT_H
+#define PERSISTSPLIT_H
+
+#include "struct.h"
+
+
+namespace persist {
+
+#if !defined(PERSISTSTRUCT_POINTERS)
+/**
+ * A class offering persistent storage access to a user supplied structure where a few frequently
+ * changing (hot) fields are stored apart from the rarely changing (cold) remainder.  Each part is
+ * stored in its own wear levelled ring with its own slot size, so saving a hot change programs
+ * only the hot part.  The application still works with one ADT &lt;T&gt;.
+ *
+ * Hot fields are declared by grouping them into a member structure of ADT:
+ *
+ * \code
+ * typedef struct {
+ *     uint32_t run_hours;
+ *     uint8_t  last_mode;
+ * }hot_t;
+ *
+ * typedef struct {
+ *     uint8_t  serial[16];
+ *     int16_t  calibration[32];
+ *     hot_t    hot;
+ * }cfg_t;
+ *
+ * persist::Split<cfg_t, hot_t, &cfg_t::hot> g_cfg_ps(g_media, cold_start, 4, hot_start, 16);
+ * \endcode
+ *
+ * \note Cold ring stores the entire ADT, including a snapshot of hot fields taken when cold data
+ * last changed.  Should the hot ring fail to load, the snapshot is used as a fall back
+ * \attention Not available with PERSISTSTRUCT_POINTERS
+ *
+ * \tparam T ADT type name managed and storaged by instance
+ * \tparam H hot member type
+ * \tparam HOT pointer to hot member of ADT &lt;T&gt;
+ */
+template<typename T, typename H, H T::*HOT>
+class Split {
+public:
+    /**
+     * Constructor based upon required ware level of each part.  You will have to load your ADT via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] cold_start location or offset into media for first cold write.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] cold_ware_level cold ware levels N (maximum)
+     * \param[in] hot_start location or offset into media for first hot write.  Numeric may not represent
+     * a valid CPU address.  Must not overlap cold storage.
+     * \param[in] hot_ware_level hot ware levels N (maximum)
+     */
+    Split(Media &m, uint32_t *cold_start, uint8_t cold_ware_level, uint32_t *hot_start, uint8_t hot_ware_level) :
+            cold_(m, cold_start, cold_ware_level), hot_(m, hot_start, hot_ware_level) {
+    } // Split(...)
+
+
+    /**
+     * Load ADT from media.  Cold part is loaded first and then hot fields from hot ring replace
+     * the cold snapshot
+     *
+     * \param[out] data block ADT
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool Load(T &data) {
+        bool ok = cold_.Load(data);
+
+        if (ok) {
+            // Hot ring optional, cold snapshot used when unavailable
+            hot_.Load(data.*HOT);
+        }
+
+        return ok;
+    } // Load(...)
+
+
+    /**
+     * Save ADT to media.  Only the parts that differ from those last loaded or saved are written.  Hot
+     * part is written first, cold part (with its hot snapshot) only once hot succeeded.  Power loss
+     * between the two leaves new hot fields over old cold ones, never a hot ring older than the snapshot
+     *
+     * \param[in] data block ADT
+     * \param[in] not_loaded_force default false.  Required if not loaded to force save of given ADT to media
+     * Normally this parameter default would be used but when virgin media this flag is required for inital
+     * write.
+     * \retval true on success (including nothing to save)
+     * \retval false failed
+     */
+    bool Save(T &data, bool not_loaded_force=false) {
+        bool ok = true;
+
+        // Hot part changed?  First, as Load lets the hot ring override the cold snapshot.  Hot ring may be
+        // empty once cold is loaded, nothing written when cold would refuse
+        if (!hot_.IsSame(data.*HOT)) {
+            ok = hot_.Save(data.*HOT, not_loaded_force || (cold_.IsLoaded() && !hot_.IsLoaded()));
+        }
+
+        // Cold part changed?  Hot fields excluded from comparison
+        if (ok && !cold_.IsSame(data, GetHotOffset(data), sizeof(H))) {
+            ok = cold_.Save(data, not_loaded_force);
+        }
+
+        return ok;
+    } // Save(...)
+
+
+    /**
+     * Unload both parts.  Clears data and loaded state
+     */
+    void Unload() {
+        cold_.Unload();
+        hot_.Unload();
+    } // Unload()
+
+
+    /**
+     * Query ADT been loaded from media
+     *
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool IsLoaded() const {
+        return cold_.IsLoaded();
+    } // IsLoaded()
+
+
+    /**
+     * Get cold part persistent structure
+     *
+     * \note Use as debugging aid
+     *
+     * \return Reference
+     */
+    Struct<T>& GetCold() {
+        return cold_;
+    } // GetCold()
+
+
+    /**
+     * Get hot part persistent structure
+     *
+     * \note Use as debugging aid
+     *
+     * \return Reference
+     */
+    Struct<H>& GetHot() {
+        return hot_;
+    } // GetHot()
+
+/*! \cond PRIVATE */
+protected:
+    /**
+     * Get offset of hot member within ADT
+     *
+     * \param[in] data block ADT
+     * \return Offset, Bytes
+     */
+    static uint32_t GetHotOffset(const T &data) {
+        return static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(&(data.*HOT)) - reinterpret_cast<const uint8_t*>(&data));
+    } // GetHotOffset(...)
+
+
+protected:
+    Struct<T>    cold_;
+    Struct<H>    hot_;
+/*! \endcond */
+}; // class Split
+#endif // !PERSISTSTRUCT_POINTERS
+
+} // namespace persist
+
+#endif // PERSISTSPLIT_H
@@ -11,11 +11,31 @@
 #if defined(ARDUINO_ARCH_STM32)
 
 #include "media.h"                // Persist base
+#include "hint.h"
 
 // These are what we are wrapping...
 #include "stm32/f103/flash.h"
 #include "stm32/f103/crc.h"
 
+/*! \cond PRIVATE */
+#if !defined(STM32F103X_BKP)
+// Backup domain, power control and clock enable registers
+#define STM32F103X_BKP                          ((uint32_t)0x40006C00)
+#define STM32F103X_PWR_CR                       ((uint32_t)0x40007000)
+#define STM32F103X_RCC_APB1ENR_ADDR             ((uint32_t)0x4002101C)
+#define STM32F103X_RCC_APB1ENR_BKPEN            0x08000000
+#define STM32F103X_RCC_APB1ENR_PWREN            0x10000000
+#define STM32F103X_PWR_CR_DBP                   0x00000100
+#endif // !defined(STM32F103X_BKP)
+
+#if !defined(_MSC_VER)
+// Linker script symbols, initialised data is loaded from flash after code
+extern "C" uint32_t _sidata;
+extern "C" uint32_t _sdata;
+extern "C" uint32_t _edata;
+#endif // !defined(_MSC_VER)
+/*! \endcond */
+
 namespace wrap {
 /**
  * Wrapper for MCU specialised API to flash module and CRC.  Each media type 
@@ -54,6 +74,46 @@ public:
         return stm32f103x::Crc::Generate(buffer, static_cast<uint32_t>(size_u16));
     }
 
+    const uint32_t* Map(const uint32_t *buffer) const {
+        // On-chip flash is memory mapped
+        return buffer;
+    }
+
+    bool Write(const uint32_t *buffer, const uint32_t *data, const int16_t size_u32) {
+        // For realtime os, add lock as required
+        bool done;
+
+        stm32f103x::Flash::Unlock();
+        done = stm32f103x::Flash::Write32Buffer(buffer, data, size_u32);
+        stm32f103x::Flash::Lock();
+
+        return done;
+    }
+
+    bool Erase(const uint32_t *buffer, const uint32_t pages) {
+        // For realtime os, add lock as required
+        bool done;
+
+        stm32f103x::Flash::Unlock();
+        done = stm32f103x::Flash::ErasePages(buffer, static_cast<int32_t>(pages), stm32f103x::Flash::page_size>>2);
+        stm32f103x::Flash::Lock();
+
+        return done;
+    }
+
+    uint32_t GetEraseState() const {
+        return STM32F103X_FLASH_NOR_ERASE_STATE;
+    }
+
+    uint32_t* GetImageEnd() const {
+#if defined(_MSC_VER)
+        return NULL;
+#else // !defined(_MSC_VER)
+        // Image end is load address of initialised data plus its size
+        return &_sidata + (&_edata - &_sdata);
+#endif // !defined(_MSC_VER)
+    }
+
 #if defined(_MSC_VER)
     void InjectWriteError(const bool state) const {
         stm32f103x::Flash::write_error_inject = state;
@@ -64,6 +124,57 @@ public:
     }
 #endif // defined(_MSC_VER)
 }; // class Flash
+
+
+/**
+ * Slot location hint store in 2 backup domain data registers (BKP_DRx, 16bit).  Retained through
+ * reset and, with VBAT supplied, power loss.  Slot and its inverse are stored so a lost hint is detected
+ */
+class BackupHint : public persist::Hint {
+public:
+    /**
+     * Constructor.  Enables backup domain clocks and write access
+     *
+     * \param[in] reg first data register, 1 to 9.  Registers reg and reg+1 are used
+     */
+    BackupHint(const uint8_t reg) : reg_(reg) {
+#if !defined(_MSC_VER)
+        *reinterpret_cast<volatile uint32_t*>(STM32F103X_RCC_APB1ENR_ADDR) |= STM32F103X_RCC_APB1ENR_BKPEN | STM32F103X_RCC_APB1ENR_PWREN;
+        *reinterpret_cast<volatile uint32_t*>(STM32F103X_PWR_CR) |= STM32F103X_PWR_CR_DBP;
+#endif // !defined(_MSC_VER)
+    }
+
+    bool Get(uint16_t &slot) {
+        slot = static_cast<uint16_t>(*Register(reg_));
+
+        return static_cast<uint16_t>(*Register(reg_ + 1)) == static_cast<uint16_t>(~slot);
+    } // Get(...)
+
+    bool Set(const uint16_t slot) {
+        uint16_t s;
+
+        *Register(reg_) = slot;
+        *Register(reg_ + 1) = static_cast<uint16_t>(~slot);
+
+        return Get(s) && s == slot;
+    } // Set(...)
+
+protected:
+#if defined(_MSC_VER)
+    static uint32_t* Register(const uint8_t n) {
+        static uint32_t r[11];
+
+        return &r[n % 11];
+    }
+#else // !defined(_MSC_VER)
+    static volatile uint32_t* Register(const uint8_t n) {
+        // BKP_DR1 at offset 4, 32bit aligned
+        return reinterpret_cast<volatile uint32_t*>(STM32F103X_BKP + (static_cast<uint32_t>(n) << 2));
+    }
+#endif // !defined(_MSC_VER)
+
+    uint8_t reg_;
+}; // class BackupHint
 } // namespace wrap
 
 #endif // ARDUINO_ARCH_STM32
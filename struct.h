@@ -15,6 +15,8 @@
 #include <iomanip>
 #endif // defined(_MSC_VER)
 
+#include "hint.h"
+
 
 namespace persist {
 
@@ -36,6 +38,251 @@ namespace persist {
 #define PERSISTSTRUCT_SIZE(s,ps,l)              ((persist::Struct<s>::GetStorageUnitSize() / ps) + \
                                                     ((persist::Struct<s>::GetStorageUnitSize() % ps) ? 1 : 0) * ps * l)
 
+#if !defined(PERSISTSTRUCT_NOINIT)
+/**
+ * Place variable in RAM not cleared by reset, used for warm reset shadow (see Struct::AttachShadow).
+ * Define for your toolchain if section name differs, linker script must provide the section.
+ */
+#if defined(__GNUC__)
+#define PERSISTSTRUCT_NOINIT                    __attribute__ ((section (".noinit")))
+#else // !defined(__GNUC__)
+#define PERSISTSTRUCT_NOINIT
+#endif // !defined(__GNUC__)
+#endif // !defined(PERSISTSTRUCT_NOINIT)
+
+/**
+ * Standard data block header policy.  32bit CRC, 32bit counter and data block size, 12 Bytes.
+ *
+ * A header policy describes the header written in front of each stored copy of ADT and how it
+ * is checked.  Use with \ref Struct template parameter H
+ */
+struct HeadStd {
+#pragma pack(push, 4) // Optimised for ARM
+    /**
+     * Data block ADT header
+     */
+    struct tHead {
+        uint32_t crc;
+        uint32_t counter;
+        uint32_t bytes;
+    };
+#pragma pack(pop)
+
+    /**
+     * Clear header
+     *
+     * \param[out] h header
+     */
+    static void Clear(tHead &h) {
+        h.bytes = h.crc = h.counter = 0;
+    } // Clear(...)
+
+    /**
+     * Get write counter
+     *
+     * \param[in] h header
+     * \return Counter
+     */
+    static uint32_t GetCounter(const tHead &h) {
+        return h.counter;
+    } // GetCounter(...)
+
+    /**
+     * Set write counter
+     *
+     * \param[out] h header
+     * \param[in] counter value
+     */
+    static void SetCounter(tHead &h, const uint32_t counter) {
+        h.counter = counter;
+    } // SetCounter(...)
+
+    /**
+     * Query, is counter a newer than counter b
+     *
+     * \param[in] a counter
+     * \param[in] b counter
+     * \retval true a newer
+     * \retval false a same or older
+     */
+    static bool IsNewer(const uint32_t a, const uint32_t b) {
+        return a > b;
+    } // IsNewer(...)
+
+    /**
+     * Seal header with CRC of data and data block size
+     *
+     * \param[out] h header
+     * \param[in] crc CRC of data
+     * \param[in] bytes data block size (Bytes)
+     */
+    static void Seal(tHead &h, const uint32_t crc, const uint32_t bytes) {
+        h.bytes = bytes;
+        h.crc = crc;
+    } // Seal(...)
+
+    /**
+     * Query, is header plausible without checking data.  Used to find the most recent copy
+     *
+     * \param[in] h header
+     * \param[in] bytes data block size (Bytes)
+     * \retval true plausible
+     * \retval false not a header or different data block
+     */
+    static bool IsSane(const tHead &h, const uint32_t bytes) {
+        return h.bytes == bytes;
+    } // IsSane(...)
+
+    /**
+     * Query, does header match CRC of data and data block size
+     *
+     * \param[in] h header
+     * \param[in] crc CRC of data
+     * \param[in] bytes data block size (Bytes)
+     * \retval true match
+     * \retval false mismatch
+     */
+    static bool IsSealed(const tHead &h, const uint32_t crc, const uint32_t bytes) {
+        return h.bytes == bytes && h.crc == crc;
+    } // IsSealed(...)
+
+    /**
+     * Invalidate header
+     *
+     * \param[out] h header
+     */
+    static void Invalidate(tHead &h) {
+        h.bytes = h.crc = 0;
+    } // Invalidate(...)
+}; // struct HeadStd
+
+
+/**
+ * Compact data block header policy.  16bit CRC field and 16bit counter, 4 Bytes.  Suits small pages
+ * like AVR EEPROM where \ref HeadStd overhead is large compared to ADT.  The CRC field holds a 16bit
+ * fold of the 32bit CRC XOR-ed with the data block size, so size is checked implicitly with the data
+ * and a data block of other size fails as a bad CRC.  The counter wraps, so comparison uses serial
+ * number arithmetic.
+ *
+ * \code
+ * persist::Struct<cfg_t, persist::HeadCompact> g_cfg_ps(g_media, g_media.GetStart(), 8);
+ * \endcode
+ */
+struct HeadCompact {
+    /**
+     * Data block ADT header
+     */
+    struct tHead {
+        uint16_t crc;                       // CRC fold XOR size, never all ones
+        uint16_t counter;
+    };
+
+    /**
+     * Clear header
+     *
+     * \param[out] h header
+     */
+    static void Clear(tHead &h) {
+        h.crc = h.counter = 0;
+    } // Clear(...)
+
+    /**
+     * Get write counter
+     *
+     * \param[in] h header
+     * \return Counter
+     */
+    static uint32_t GetCounter(const tHead &h) {
+        return h.counter;
+    } // GetCounter(...)
+
+    /**
+     * Set write counter, stored modulo 2^16
+     *
+     * \param[out] h header
+     * \param[in] counter value
+     */
+    static void SetCounter(tHead &h, const uint32_t counter) {
+        h.counter = static_cast<uint16_t>(counter);
+    } // SetCounter(...)
+
+    /**
+     * Query, is counter a newer than counter b.  Serial number arithmetic, a is newer when less than
+     * half the counter range ahead of b
+     *
+     * \param[in] a counter
+     * \param[in] b counter
+     * \retval true a newer
+     * \retval false a same or older
+     */
+    static bool IsNewer(const uint32_t a, const uint32_t b) {
+        return static_cast<int16_t>(static_cast<uint16_t>(a - b)) > 0;
+    } // IsNewer(...)
+
+    /**
+     * Seal header with CRC of data and data block size
+     *
+     * \param[out] h header
+     * \param[in] crc CRC of data
+     * \param[in] bytes data block size (Bytes)
+     */
+    static void Seal(tHead &h, const uint32_t crc, const uint32_t bytes) {
+        h.crc = Fold(crc, bytes);
+    } // Seal(...)
+
+    /**
+     * Query, is header plausible without checking data.  Used to find the most recent copy.  CRC fold
+     * can't be all ones, so erase state is never a header.  Size is checked with data by \ref IsSealed
+     *
+     * \param[in] h header
+     * \param[in] bytes data block size (Bytes), unused
+     * \retval true plausible
+     * \retval false not a header
+     */
+    static bool IsSane(const tHead &h, const uint32_t bytes) {
+        (void)bytes;
+
+        return h.crc != 0xffff;
+    } // IsSane(...)
+
+    /**
+     * Query, does header match CRC of data and data block size
+     *
+     * \param[in] h header
+     * \param[in] crc CRC of data
+     * \param[in] bytes data block size (Bytes)
+     * \retval true match
+     * \retval false mismatch
+     */
+    static bool IsSealed(const tHead &h, const uint32_t crc, const uint32_t bytes) {
+        return h.crc == Fold(crc, bytes);
+    } // IsSealed(...)
+
+    /**
+     * Invalidate header, CRC field inverted
+     *
+     * \param[out] h header
+     */
+    static void Invalidate(tHead &h) {
+        h.crc = static_cast<uint16_t>(~h.crc);
+    } // Invalidate(...)
+
+protected:
+    /**
+     * Fold CRC into 16bits XOR data block size, never all ones
+     *
+     * \param[in] crc CRC of data
+     * \param[in] bytes data block size (Bytes)
+     * \return Folded CRC
+     */
+    static uint16_t Fold(const uint32_t crc, const uint32_t bytes) {
+        uint16_t f = static_cast<uint16_t>(crc ^ (crc >> 16) ^ bytes ^ (bytes >> 16));
+
+        return (0xffff == f) ? 0xfffe : f;
+    } // Fold(...)
+}; // struct HeadCompact
+
+
 /**
  * A class offering persistent storage access to a user supplied structure with ware levelling.
  * Internally the supplied user ADT &lt;T&gt; is wrapped with a header that includes retrieval 
@@ -46,8 +293,9 @@ namespace persist {
  * a load failure at least has a chance at returning a usable (new format) structure
  *
  * \tparam T ADT type name managed and storaged by PStruct instance
+ * \tparam H data block header policy, default \ref HeadStd.  See also \ref HeadCompact
  */
-template<typename T>
+template<typename T, typename H = HeadStd>
 class Struct {
 /*! \cond PRIVATE */
 protected:
@@ -56,16 +304,12 @@ protected:
      */
     class Db {
     protected:
-#pragma pack(push, 4) // Optimised for ARM
         /**
          * Data block ADT header used to manage data type T
          */
-        struct tDbHead {
-            uint32_t crc;        // Optimize for architecture?
-            uint32_t counter;
-            uint32_t bytes;
-        };
+        typedef typename H::tHead tDbHead;
 
+#pragma pack(push, 4) // Optimised for ARM
         /**
          * Data block ADT structure.  Raw storage format written to media
          */
@@ -86,6 +330,17 @@ protected:
         tDb        db_;
 
     public:
+        /**
+         * Warm reset shadow of internal data block and its location
+         */
+        struct tShadow {
+            uint32_t    magic;
+            uint32_t    check;          // Guards offset
+            uint32_t    offset;         // Location from start, sizeof(uint32_t) multiples
+            tDb         db;
+        };
+
+
         /**
          * Default constructor, clear internal data block
          */
@@ -100,7 +355,7 @@ protected:
          * \return Size in Bytes
          */
         static constexpr uint32_t GetDbHeadSize() {
-            return sizeof(struct tDbHead);
+            return sizeof(tDbHead);
         } // GetDbHeadSize()
 
 
@@ -123,7 +378,7 @@ protected:
             for(uint32_t i = sizeof(tDbHead) / sizeof(uint32_t); i<sizeof(db_.u32) / sizeof(uint32_t); i++) {
                 db_.u32[i] = set_word;
             }
-            db_.f.meta.bytes = db_.f.meta.crc = db_.f.meta.counter = 0;
+            H::Clear(db_.f.meta);
         } // Clear()
 
 
@@ -145,13 +400,8 @@ protected:
          * \attention While bad pratice it maybe necessary in resticted memory environments
          */
         void Update(Media &m, bool first=false) {
-            if (first) {
-                db_.f.meta.counter = 0;
-            }else {
-                db_.f.meta.counter++;
-            }
-            db_.f.meta.bytes = sizeof(db_.u32);
-            db_.f.meta.crc = CalculateCRC(m);
+            H::SetCounter(db_.f.meta, first ? 0 : (H::GetCounter(db_.f.meta) + 1));
+            H::Seal(db_.f.meta, CalculateCRC(m), sizeof(db_.u32));
         } // Update(...)
 #else // !PERSISTSTRUCT_POINTERS
 
@@ -174,15 +424,36 @@ protected:
          * \param[in] first default false.  First call where internal write counter zeroed when true
          */
          void Update(Media &m, T& t, const bool first=false) {
-            if (first) {
-                db_.f.meta.counter = 0;
-            }else {
-                db_.f.meta.counter++;
-            }
-            db_.f.meta.bytes = sizeof(db_.u32);
+            H::SetCounter(db_.f.meta, first ? 0 : (H::GetCounter(db_.f.meta) + 1));
             db_.f.data = t;
-            db_.f.meta.crc = CalculateCRC(m);
+            H::Seal(db_.f.meta, CalculateCRC(m), sizeof(db_.u32));
         } // Update(...)
+
+
+        /**
+         * Query, does internal data block match supplied ADT.  An optional byte range of ADT can be
+         * excluded from comparison
+         *
+         * \param[in] t reference to ADT to compare
+         * \param[in] skip_offset default 0.  Offset of excluded range within ADT (Bytes)
+         * \param[in] skip_bytes default 0.  Size of excluded range (Bytes)
+         * \retval true same
+         * \retval false different
+         */
+        bool IsSame(const T& t, const uint32_t skip_offset = 0, const uint32_t skip_bytes = 0) const {
+            const uint8_t *a = reinterpret_cast<const uint8_t*>(&db_.f.data);
+            const uint8_t *b = reinterpret_cast<const uint8_t*>(&t);
+
+            for(uint32_t i = 0; i < sizeof(T); i++) {
+                if (i == skip_offset && skip_bytes) {
+                    i+= skip_bytes - 1;
+                }else if (a[i] != b[i]) {
+                    return false;
+                }
+            }
+
+            return true;
+        } // IsSame(...)
 #endif // !PERSISTSTRUCT_POINTERS
 
 
@@ -193,7 +464,7 @@ protected:
          * \return Read/write count n
          */
         uint32_t GetCounter() const {
-            return db_.f.meta.counter;
+            return H::GetCounter(db_.f.meta);
         } // GetCounter()
 
 
@@ -225,7 +496,7 @@ protected:
                 ok = true;
             }else {
                 // Read from storage failed so not valid
-                db_.f.meta.bytes = db_.f.meta.crc = 0;
+                H::Invalidate(db_.f.meta);
             }
             
             return ok;
@@ -245,20 +516,178 @@ protected:
             bool ok = false;
             const uint32_t *data = static_cast<uint32_t *>(&db_.u32[0]);
 
-            db_.f.meta.counter = 0;
+            H::SetCounter(db_.f.meta, 0);
             
             // Load header from storage + check?
-            if (m.Read(location, data, sizeof(tDbHead) / sizeof(uint32_t)) && (db_.f.meta.bytes == sizeof(db_.u32))) {
+            if (m.Read(location, data, sizeof(tDbHead) / sizeof(uint32_t)) && H::IsSane(db_.f.meta, sizeof(db_.u32))) {
                 ok = true;
             }else {
                 // Read from storage failed so not valid
-                db_.f.meta.bytes = db_.f.meta.crc = 0;
+                H::Invalidate(db_.f.meta);
             }
             
             return ok;
         } // ReadHeader(...)
 
 
+        /**
+         * Get offset of ADT member within raw data block, includes header
+         *
+         * \tparam F member type
+         * \param[in] member pointer to member of ADT &lt;T&gt;
+         * \return Offset, Bytes
+         */
+        template<typename F>
+        uint32_t GetOffset(F T::*member) const {
+            return static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(&(db_.f.data.*member)) - \
+                                            reinterpret_cast<const uint8_t*>(&db_.u32[0]));
+        } // GetOffset(...)
+
+
+        /**
+         * Read single ADT member from data block at given location.  Only the words covering the member
+         * are read from media, internal data block is left untouched and no CRC check is made
+         *
+         * \tparam F member type
+         * \param[in,out] m media instance reference
+         * \param[in] location pointer to location on media, numeric may not represent a valid CPU address
+         * \param[in] member pointer to member of ADT &lt;T&gt;
+         * \param[out] value destination of member read
+         * \retval true read successful
+         * \retval false read failure
+         */
+        template<typename F>
+        bool ReadField(Media &m, uint32_t* location, F T::*member, F &value) const {
+            uint32_t buffer[4];
+            uint32_t o = GetOffset(member);
+            uint32_t *l = location + (o / sizeof(uint32_t));
+            uint32_t skip = o % sizeof(uint32_t), left = sizeof(F), n, i;
+            uint8_t *d = reinterpret_cast<uint8_t*>(&value);
+            const uint8_t *s = reinterpret_cast<const uint8_t*>(&buffer[0]);
+            bool ok = true;
+
+            // Read word aligned chunks covering member, copying just the member bytes out
+            while(ok && left) {
+                n = (skip + left + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+                if (n > sizeof(buffer) / sizeof(uint32_t)) {
+                    n = sizeof(buffer) / sizeof(uint32_t);
+                }
+
+                ok = m.Read(l, buffer, static_cast<int16_t>(n));
+                if (ok) {
+                    for(i = skip; i < n * sizeof(uint32_t) && left; i++, left--) {
+                        *d++ = s[i];
+                    }
+                    l+= n;
+                    skip = 0;
+                }
+            }
+
+            return ok;
+        } // ReadField(...)
+
+
+        /**
+         * Copy internal data block to shadow
+         *
+         * \param[out] s shadow
+         * \param[in] offset location from start, sizeof(uint32_t) multiples
+         */
+        void ToShadow(tShadow &s, const uint32_t offset) const {
+            s.magic = 0;
+            s.db = db_;
+            s.offset = offset;
+            s.check = ~(GetShadowMagic() ^ offset);
+            s.magic = GetShadowMagic();
+        } // ToShadow(...)
+
+
+        /**
+         * Copy internal data block from shadow, shadow guard and data block CRC are checked
+         *
+         * \param[in,out] m media instance reference
+         * \param[in] s shadow
+         * \retval true copied and valid
+         * \retval false shadow not valid (cold reset)
+         */
+        bool FromShadow(Media &m, const tShadow &s) {
+            bool ok = s.magic == GetShadowMagic() && s.check == ~(GetShadowMagic() ^ s.offset);
+
+            if (ok) {
+                db_ = s.db;
+                ok = IsValid(m);
+            }
+
+            return ok;
+        } // FromShadow(...)
+
+
+        /**
+         * Query, is internal data block header the header on media at location
+         *
+         * \param[in,out] m media instance reference
+         * \param[in] location pointer to location on media, numeric may not represent a valid CPU address
+         * \retval true same
+         * \retval false different or read failure
+         */
+        bool IsHeaderAt(Media &m, uint32_t* location) const {
+            uint32_t h[sizeof(tDbHead) / sizeof(uint32_t)];
+            bool ok = m.Read(location, h, sizeof(h) / sizeof(uint32_t));
+
+            for(uint32_t i = 0; ok && i < sizeof(h) / sizeof(uint32_t); i++) {
+                ok = h[i] == db_.u32[i];
+            }
+
+            return ok;
+        } // IsHeaderAt(...)
+
+
+        /**
+         * Query, is internal data block the data block on media at location.  Headers are compared, in
+         * pointer mode (caller may change internal data block directly) its CRC is also checked
+         *
+         * \param[in,out] m media instance reference
+         * \param[in] location pointer to location on media, numeric may not represent a valid CPU address
+         * \retval true same
+         * \retval false different, changed or read failure
+         */
+        bool IsCurrentAt(Media &m, uint32_t* location) const {
+#if defined(PERSISTSTRUCT_POINTERS)
+            return IsHeaderAt(m, location) && IsValid(m);
+#else // !PERSISTSTRUCT_POINTERS
+            return IsHeaderAt(m, location);
+#endif // !PERSISTSTRUCT_POINTERS
+        } // IsCurrentAt(...)
+
+
+        /**
+         * Query, is header on media at location newer than internal data block
+         *
+         * \param[in,out] m media instance reference
+         * \param[in] location pointer to location on media, numeric may not represent a valid CPU address
+         * \retval true newer
+         * \retval false older, not a header or read failure
+         */
+        bool IsNewerAt(Media &m, uint32_t* location) const {
+            tDbHead h;
+
+            return m.Read(location, reinterpret_cast<uint32_t*>(&h), sizeof(h) / sizeof(uint32_t)) && \
+                    H::IsSane(h, sizeof(db_.u32)) && H::IsNewer(H::GetCounter(h), H::GetCounter(db_.f.meta));
+        } // IsNewerAt(...)
+
+
+        /**
+         * Set write counter of updated internal data block and seal it again
+         *
+         * \param[in,out] m media instance reference
+         * \param[in] counter write counter
+         */
+        void SetCounter(Media &m, const uint32_t counter) {
+            H::SetCounter(db_.f.meta, counter);
+            H::Seal(db_.f.meta, CalculateCRC(m), sizeof(db_.u32));
+        } // SetCounter(...)
+
+
         /**
          * Write internal data block ADT to media at location.  After write to media of entire ADT, CRC used to check
          *
@@ -276,6 +705,15 @@ protected:
 
 
     protected:
+        /**
+         * Get shadow magic, differs with data block size
+         *
+         * \return Magic numeric
+         */
+        static uint32_t GetShadowMagic() {
+            return 0x50535348UL ^ static_cast<uint32_t>(sizeof(tDb));
+        } // GetShadowMagic()
+
 
         /**
          * Query, is internal data block ADT value.  Uses header raw data content to determine if loaded data valid
@@ -285,48 +723,56 @@ protected:
          * \retval false invalid
          */
         bool IsValid(Media &m) const {
-            return ((db_.f.meta.bytes == sizeof(db_.u32)) && (CalculateCRC(m) == db_.f.meta.crc));
+            return H::IsSane(db_.f.meta, sizeof(db_.u32)) && H::IsSealed(db_.f.meta, CalculateCRC(m), sizeof(db_.u32));
         } // IsValid(...)
     
 
         /**
-         * Calculate CRC of internal data block ADT.  Algorithm is architecture dependant and includes the data
+         * Calculate CRC of internal data block ADT.  Algorithm is architecture dependant and excludes the data
          * header.
          *
          * \param[in,out] m media instance reference
          * \return CRC numeric of data block
          */
         uint32_t CalculateCRC(Media &m) const {
-            uint32_t crc = 0;
             const uint32_t *buffer = (const_cast<uint32_t *>(&db_.u32[sizeof(tDbHead) / sizeof(uint32_t)]));
 
-            if (db_.f.meta.bytes == sizeof(db_.u32)) {
-                crc = m.Crc(buffer, (db_.f.meta.bytes - sizeof(tDbHead)) / sizeof(uint32_t));
-            }
-
-            return crc;
+            return m.Crc(buffer, (sizeof(db_.u32) - sizeof(tDbHead)) / sizeof(uint32_t));
         } // CalculateCRC(...)
     }; // class DB
 /*! \endcond */
 
 public:
+    /**
+     * Warm reset shadow type, see \ref AttachShadow
+     */
+    typedef typename Db::tShadow tShadow;
+
+
     /**
      * Constructor based upon required ware level. You will have to load your ADT via \ref Load
      *
      * \param[in,out] m media instance reference
      * \param[in] start location or offset into media for first write.  Numeric may not represent 
      * a valid CPU address.
-     * \param[in] ware_level ware levels N (maximum)
+     * \param[in] ware_level ware levels N (maximum).  Limited to 2 on media without erase, see Media::NeedsErase
      */
     Struct(Media &m, uint32_t *start, uint8_t ware_level) : media_(m), start_(start), db_(), ware_level_(ware_level) {
         current_.loaded = false;
         current_.location = 0;
+        shadow_ = NULL;
+        hint_ = NULL;
+        slot_search_ = false;
+#if defined(PERSISTSTRUCT_POINTERS)
+        lazy_ = pending_ = false;
+#endif // PERSISTSTRUCT_POINTERS
         pages_ = Struct::GetStorageUnitSize() / media_.GetPageSize();
         if (Struct::GetStorageUnitSize() % media_.GetPageSize()) {
             pages_++;
         }
         struct_pages_u32_ = pages_ * (media_.GetPageSize()>>2);
         pages_ *= ware_level_;
+        SetEraseFreeProfile();
     } // Struct(...)
 
 
@@ -343,14 +789,21 @@ public:
     Struct(Media &m, uint32_t *start, uint32_t *end) : media_(m), start_(start), db_() {
         current_.loaded = false;
         current_.location = 0;
+        shadow_ = NULL;
+        hint_ = NULL;
+        slot_search_ = false;
+#if defined(PERSISTSTRUCT_POINTERS)
+        lazy_ = pending_ = false;
+#endif // PERSISTSTRUCT_POINTERS
         uint32_t ps = Struct::GetStorageUnitSize() / media_.GetPageSize();
         if (Struct::GetStorageUnitSize() % media_.GetPageSize()) {
             ps++;
         }
         struct_pages_u32_ = ps * (media_.GetPageSize()>>2);
-        pages_ = (reinterpret_cast<uint32_t>(end) - reinterpret_cast<uint32_t>(start)) / media_.GetPageSize();
+        pages_ = static_cast<uint32_t>((end - start) * sizeof(uint32_t)) / media_.GetPageSize();
         pages_-= pages_ % ps;
         ware_level_ = pages_ / ps;
+        SetEraseFreeProfile();
     } // Struct(...)
 
 
@@ -364,94 +817,154 @@ public:
     } // Unload()
 
 
+    /**
+     * Attach warm reset shadow.  Shadow holds a copy of the current data block and its location in
+     * RAM not cleared by reset (.noinit).  After a watchdog or software reset \ref Load validates the
+     * shadow against the header on media and returns without scanning.
+     *
+     * \code
+     * persist::Struct<cfg_t>::tShadow g_cfg_shadow PERSISTSTRUCT_NOINIT;
+     *
+     * g_cfg_ps.AttachShadow(&g_cfg_shadow);
+     * g_cfg_ps.Load(cfg);
+     * \endcode
+     *
+     * \note Shadow is updated on every \ref Load and \ref Save, costing a RAM copy of the data block
+     *
+     * \param[in] shadow pointer to shadow or NULL to detach
+     */
+    void AttachShadow(tShadow *shadow) {
+        shadow_ = shadow;
+    } // AttachShadow(...)
+
+
+    /**
+     * Attach slot location hint store.  The slot index of each data block written by \ref Save is
+     * recorded and a cold \ref Load tries the hinted slot and its following neighbours before falling
+     * back to a scan of the storage.
+     *
+     * \code
+     * wrap::EeHint g_cfg_hint(0);    // AVR EEPROM address 0, flash storage
+     *
+     * g_cfg_ps.AttachHint(&g_cfg_hint);
+     * \endcode
+     *
+     * \note Each \ref Save also writes the hint store, choose a store with suitable endurance
+     *
+     * \param[in] hint pointer to hint store or NULL to detach
+     */
+    void AttachHint(Hint *hint) {
+        hint_ = hint;
+    } // AttachHint(...)
+
+
+    /**
+     * Set first save slot search.  A forced \ref Save when not loaded (factory reset, provisioning)
+     * normally writes the first slot with write counter 0, wearing it more than the rest.  With search
+     * the slot headers are scanned, the write counter continues from the newest (stale) header found and
+     * the slot right after it is written, the same slot a loaded save would use.
+     *
+     * \param[in] search true to search
+     */
+    void SetSlotSearch(const bool search) {
+        slot_search_ = search;
+    } // SetSlotSearch(...)
+
+
 #if defined(PERSISTSTRUCT_POINTERS)
     /**
-     * Load internal data block ADT from media
+     * Set lazy load.  \ref Load only checks a data block header is on media and registers intent, the
+     * first following \ref Get performs the load and its CRC check, so defensive \ref Load calls on paths
+     * that never use the data cost little.
      *
-     * \return bool Loaded status
+     * \attention Access data through \ref Get after \ref Load, a pointer held from before is refreshed
+     * by the deferred load
+     *
+     * \param[in] lazy true to defer
+     */
+    void SetLazy(const bool lazy) {
+        lazy_ = lazy;
+        if (!lazy_) {
+            pending_ = false;
+        }
+    } // SetLazy(...)
+
+
+    /**
+     * Load internal data block ADT from media.  When already loaded only the header on media is read
+     * and compared, the data block is read again only when it differs.
+     *
+     * \note In lazy mode (see \ref SetLazy) the result only tells a header was found, false still means
+     * storage needs initialising (\ref Save with force).  Data blocks all failing their CRC are found by
+     * \ref IsLoaded, which performs the deferred load
+     *
+     * \retval true loaded, or lazy load pending
+     * \retval false not loaded
      */
     bool Load() {
+        bool ok;
+
+        if (lazy_) {
+            ok = current_.loaded || HasHeader();
+            pending_ = ok;
+        }else {
+            ok = Locate();
+        }
+
+        return ok;
+    } // Load()
 #else // !PERSISTSTRUCT_POINTERS
     /**
-     * Load data block ADT from media
+     * Load data block ADT from media.  When already loaded only the header on media is read and
+     * compared, the data block is read again only when it differs.
      *
      * \param[out] data block         ADT
      * \retval true loaded
      * \retval false not loaded
      */
     bool Load(T &data) {
-#endif // !PERSISTSTRUCT_POINTERS
-        bool ok = false;
-        uint32_t *l;
+        bool ok = Locate();
 
-        // Make sure size(T + header) <= storage size?
-        if (db_.WillFit(media_, pages_)) {
-            // Loaded already?
-            if (current_.loaded) {
-                // Reload current
-                if (db_.Read(media_, current_.location)) {
-#if !defined(PERSISTSTRUCT_POINTERS)
-                    db_.Get(data);    // Take data
+        if (ok) {
+            db_.Get(data);    // Take data
+        }
+
+        return ok;
+    } // Load(...)
 #endif // !PERSISTSTRUCT_POINTERS
-                    ok = true;
-                }else {
-                    // Force cold load
-                    current_.loaded = false;
-                }
-            }
 
-            // Not loaded? (cold load?)
-            if (!current_.loaded) {
-                uint32_t c = 0, s = 0, i = pages_;
 
-                // Attempt to find valid data block with largest counter (header only, crc may still be invalid)
-                // this should be the last written block.
-                l = start_;
-                do {
-                    if (db_.ReadHeader(media_, l)) {
-                        if (!s || db_.GetCounter() > c) {
-                            c = db_.GetCounter();
-                            l = GetNextLocation(l);
-                            s = 1;
-                        }else {
-                            // This next block has a lower or equal counter than at least the last one we found so assume
-                            break;
-                        }
-                    }else {
-                        l = GetNextLocation(l);
-                    }
-                }while(--i>0);
-                
-                // We find any?
-                if (s) {
-                    /* We should have the most recent header (last written).  now check crc to validate and work
-                       backwards until a crc is valid and take. */
-                    i = pages_;
-                    do {
-                        l = GetPreviousLocation(l);
+#if defined(PERSISTSTRUCT_POINTERS)
+    /**
+     * Load internal data block ADT with given write counter from media, rather than the most recent.
+     * Used by \ref Group to load the committed copy
+     *
+     * \param[in] counter write counter of required data block
+     * \return bool Loaded status
+     */
+    bool Load(const uint32_t counter) {
+        return LocateCounter(counter);
+    } // Load(...)
+#else // !PERSISTSTRUCT_POINTERS
+    /**
+     * Load data block ADT with given write counter from media, rather than the most recent.  Used by
+     * \ref Group to load the committed copy
+     *
+     * \param[out] data block ADT
+     * \param[in] counter write counter of required data block
+     * \retval true loaded
+     * \retval false not found
+     */
+    bool Load(T &data, const uint32_t counter) {
+        bool ok = LocateCounter(counter);
 
-                        // Load at l
-                        if (db_.Read(media_, l)) {
-                            current_.loaded = true;
-                            current_.location = l;
-#if !defined(PERSISTSTRUCT_POINTERS)
-                            db_.Get(data);    // Take data
-#endif // !PERSISTSTRUCT_POINTERS
-                            ok = true;
-                            break;
-                        }
-#if defined(_MSC_VER)
-                        else {
-                            std::cout << std::endl << "db_.read(...) failed @ " << std::hex << std::setw(8) << std::setfill('0') << (l - start_) << std::endl;
-                        }
-#endif // defined(_MSC_VER)
-                    }while(--i>0);
-                }
-            }
+        if (ok) {
+            db_.Get(data);    // Take data
         }
 
         return ok;
     } // Load(...)
+#endif // !PERSISTSTRUCT_POINTERS
 
 
 #if defined(PERSISTSTRUCT_POINTERS)
@@ -500,17 +1013,26 @@ public:
         bool attempt = false;
         uint32_t *l = NULL;        // No write
 
+#if defined(PERSISTSTRUCT_POINTERS)
+        Resolve();
+#endif // PERSISTSTRUCT_POINTERS
+
         // Make sure size(T + header) <= storage size?
         if (db_.WillFit(media_, pages_)) {
             // If not loaded and force (assume storage empty.  it might be the user invoked api incorrectly but ...)
             if (!current_.loaded) {
                 if (not_loaded_force) {
-                    l = start_;
+                    uint32_t c = 0;
+
+                    l = slot_search_ ? FindFirstSlot(c) : start_;
 #if defined(PERSISTSTRUCT_POINTERS)
                     db_.Update(media_, true);    // Counter=0
 #else // !PERSISTSTRUCT_POINTERS
                     db_.Update(media_, data, true);    // Counter=0
 #endif // !PERSISTSTRUCT_POINTERS
+                    if (c) {
+                        db_.SetCounter(media_, c);    // Continue stale sequence
+                    }
                     attempt = true;
                 }
             }else {
@@ -527,6 +1049,11 @@ public:
             if (attempt) {
                 uint32_t i = pages_;
 
+                // Shadow stale until write done
+                if (shadow_) {
+                    shadow_->magic = 0;
+                }
+
                 // Exclude overwritting current.  Rare situation where all write attempts fail we at least want something to load, i.e. the current
                 if (current_.loaded) {
                     i--;
@@ -549,6 +1076,11 @@ public:
                         l = GetNextLocation(l);    // Next
                     }
                 }while(--i>0);
+
+                if (done) {
+                    UpdateShadow();
+                    UpdateHint();
+                }
             }
         }
 
@@ -567,11 +1099,125 @@ public:
     T* Get() const {
         return db_.Get();
     } // Get()
+
+
+    /**
+     * Get internal data block, performing a deferred lazy \ref Load first
+     *
+     * \return ADT &lt;T&gt; pointer
+     */
+    T* Get() {
+        Resolve();
+
+        return db_.Get();
+    } // Get()
+#endif // !PERSISTSTRUCT_POINTERS
+
+
+    /**
+     * Read a single member of ADT from media without loading the entire data block into caller memory.
+     * The most recent valid data block is located (and CRC checked) once, following reads only access
+     * the media words covering the member.  Memory mapped media is accessed directly.
+     *
+     * \note The first call on a cold start still reads and CRC checks the whole data block, as \ref Load
+     * does, validation is not deferred.  Only repeat calls save media reads
+     *
+     * \code
+     * uint32_t v;
+     * if (g_cfg_ps.ReadField(&cfg_t::value1, v)) { ... }
+     * \endcode
+     *
+     * \tparam F member type
+     * \param[in] member pointer to member of ADT &lt;T&gt;
+     * \param[out] value destination of member read
+     * \retval true read success
+     * \retval false not loaded or read failure
+     */
+    template<typename F>
+    bool ReadField(F T::*member, F &value) {
+        const F *p = GetField(member);
+        bool ok = false;
+
+        if (p) {
+            // Memory mapped, byte copy (member may be an array or not aligned)
+            const uint8_t *s = reinterpret_cast<const uint8_t*>(p);
+            uint8_t *d = reinterpret_cast<uint8_t*>(&value);
+            for(uint32_t i = 0; i < sizeof(F); i++) {
+                d[i] = s[i];
+            }
+            ok = true;
+        }else if (current_.loaded) {
+            ok = db_.ReadField(media_, current_.location, member, value);
+        }
+
+        return ok;
+    } // ReadField(...)
+
+
+    /**
+     * Get pointer to a single member of ADT within memory mapped media.  As \ref ReadField but without
+     * any copy.  The most recent valid data block is located (and CRC checked) once, on the first call
+     * reading the whole data block.
+     *
+     * \attention Pointer is into media and becomes stale on \ref Save
+     * \tparam F member type
+     * \param[in] member pointer to member of ADT &lt;T&gt;
+     * \return Member pointer or NULL when not loaded or media not memory mapped
+     */
+    template<typename F>
+    const F* GetField(F T::*member) {
+        const uint8_t *p = NULL;
+
+#if defined(PERSISTSTRUCT_POINTERS)
+        Resolve();
+#endif // PERSISTSTRUCT_POINTERS
+        if (current_.loaded || Locate()) {
+            p = reinterpret_cast<const uint8_t*>(media_.Map(current_.location));
+            if (p) {
+                p+= db_.GetOffset(member);
+            }
+        }
+
+        return reinterpret_cast<const F*>(p);
+    } // GetField(...)
+
+
+#if !defined(PERSISTSTRUCT_POINTERS)
+    /**
+     * Query, does given ADT match the currently loaded or last saved data block.  Use to skip
+     * a \ref Save when nothing changed
+     *
+     * \param[in] data block ADT to compare
+     * \param[in] skip_offset default 0.  Offset of range within ADT excluded from comparison (Bytes)
+     * \param[in] skip_bytes default 0.  Size of excluded range (Bytes)
+     * \retval true loaded and same
+     * \retval false not loaded or different
+     */
+    bool IsSame(const T &data, const uint32_t skip_offset = 0, const uint32_t skip_bytes = 0) const {
+        return current_.loaded && db_.IsSame(data, skip_offset, skip_bytes);
+    } // IsSame(...)
 #endif // !PERSISTSTRUCT_POINTERS
 
+
+#if defined(PERSISTSTRUCT_POINTERS)
+    /**
+     * Query internal data block ADT been loaded from media, performing a deferred lazy \ref Load first
+     * 
+     * \retval true loaded
+     * \retval false not loaded
+     */
+    bool IsLoaded() {
+        Resolve();
+
+        return current_.loaded;
+    } // IsLoaded()
+#endif // PERSISTSTRUCT_POINTERS
+
+
     /**
      * Query internal data block ADT been loaded from media
      * 
+     * \note A deferred lazy \ref Load is not performed, use on non const instance for that
      * \retval true loaded
      * \retval false not loaded
      */
@@ -652,6 +1298,211 @@ public:
 
 /*! \cond PRIVATE */
 protected:
+    /**
+     * Locate most recent valid internal data block ADT on media and read it into internal data block.  When
+     * already loaded, the header at the current location is compared and the data block re-read only when
+     * different.  Only on read failure is a cold load (scan) performed.
+     *
+     * \retval true located and loaded
+     * \retval false not found
+     */
+    bool Locate() {
+        bool ok = false;
+        uint32_t *l;
+
+        // Make sure size(T + header) <= storage size?
+        if (db_.WillFit(media_, pages_)) {
+            // Loaded already?
+            if (current_.loaded) {
+                // Current unchanged on media (header only)?  Reload current otherwise
+                if (db_.IsCurrentAt(media_, current_.location)) {
+                    ok = true;
+                }else if (db_.Read(media_, current_.location)) {
+                    ok = true;
+                }else {
+                    // Force cold load
+                    current_.loaded = false;
+                }
+            }
+
+            // Not loaded, warm reset or hinted?
+            if (!current_.loaded && (LoadShadow() || LoadHint())) {
+                ok = true;
+            }
+
+            // Not loaded? (cold load?)
+            if (!current_.loaded) {
+                uint32_t c = 0, s = 0, i = pages_;
+
+                // Attempt to find valid data block with largest counter (header only, crc may still be invalid)
+                // this should be the last written block.
+                l = start_;
+                do {
+                    if (db_.ReadHeader(media_, l)) {
+                        if (!s || H::IsNewer(db_.GetCounter(), c)) {
+                            c = db_.GetCounter();
+                            l = GetNextLocation(l);
+                            s = 1;
+                        }else {
+                            // This next block has a lower or equal counter than at least the last one we found so assume
+                            break;
+                        }
+                    }else {
+                        l = GetNextLocation(l);
+                    }
+                }while(--i>0);
+                
+                // We find any?
+                if (s) {
+                    /* We should have the most recent header (last written).  now check crc to validate and work
+                       backwards until a crc is valid and take. */
+                    i = pages_;
+                    do {
+                        l = GetPreviousLocation(l);
+
+                        // Load at l
+                        if (db_.Read(media_, l)) {
+                            current_.loaded = true;
+                            current_.location = l;
+                            ok = true;
+                            UpdateHint();    // Hint missing or stale
+                            break;
+                        }
+#if defined(_MSC_VER)
+                        else {
+                            std::cout << std::endl << "db_.read(...) failed @ " << std::hex << std::setw(8) << std::setfill('0') << (l - start_) << std::endl;
+                        }
+#endif // defined(_MSC_VER)
+                    }while(--i>0);
+                }
+            }
+
+            if (ok) {
+                UpdateShadow();
+            }
+        }
+
+        return ok;
+    } // Locate()
+
+
+    /**
+     * Load internal data block from attached warm reset shadow.  Shadow must be valid, within storage,
+     * its header must be the header at its location on media and the following location not newer
+     *
+     * \retval true loaded
+     * \retval false no shadow or not valid
+     */
+    bool LoadShadow() {
+        bool ok = false;
+
+        if (shadow_ && shadow_->offset < pages_ * (media_.GetPageSize()>>2) && !(shadow_->offset % struct_pages_u32_)) {
+            // Following location newer when written without shadow
+            ok = db_.FromShadow(media_, *shadow_) && db_.IsHeaderAt(media_, start_ + shadow_->offset) && \
+                    !db_.IsNewerAt(media_, GetNextLocation(start_ + shadow_->offset));
+            if (ok) {
+                current_.loaded = true;
+                current_.location = start_ + shadow_->offset;
+            }else {
+                db_.Clear();
+            }
+        }
+
+        return ok;
+    } // LoadShadow()
+
+
+    /**
+     * Load internal data block from slot recorded by attached hint store.  The hinted slot header is
+     * followed while the next slot header is newer (hint not recorded before power loss), limited to
+     * a few neighbours.  When the newest header found has a damaged data block (save cut) the previous
+     * slot is taken, as a scan would.  When the hinted slot holds no header (save over a stale hint cut
+     * before writing) the previous slot is taken if neither of the two following it is newer.  Data block
+     * CRC is checked.
+     *
+     * \retval true loaded
+     * \retval false no hint store, hint not valid or mismatch
+     */
+    bool LoadHint() {
+        uint32_t *h, *l, *n;
+        uint16_t slot;
+        uint8_t i;
+        bool ok = false;
+
+        if (hint_ && hint_->Get(slot) && slot < ware_level_) {
+            h = l = start_ + static_cast<uint32_t>(slot) * struct_pages_u32_;
+            for(i = 0; i < 3 && db_.ReadHeader(media_, l); i++) {
+                n = GetNextLocation(l);
+                if (!db_.IsNewerAt(media_, n)) {
+                    ok = db_.Read(media_, l);
+                    if (!ok) {
+                        l = GetPreviousLocation(l);
+                        ok = db_.Read(media_, l);
+                    }
+                    break;
+                }
+                l = n;
+            }
+
+            // Hinted slot not a header, previous neighbour
+            if (!ok && l == h) {
+                l = GetPreviousLocation(h);
+                ok = l != h && db_.ReadHeader(media_, l) && !db_.IsNewerAt(media_, h) && \
+                        !db_.IsNewerAt(media_, GetNextLocation(h)) && db_.Read(media_, l);
+            }
+
+            if (ok) {
+                current_.loaded = true;
+                current_.location = l;
+            }else {
+                db_.Clear();
+            }
+        }
+
+        return ok;
+    } // LoadHint()
+
+
+    /**
+     * Update attached warm reset shadow with current data block
+     */
+    void UpdateShadow() {
+        if (shadow_) {
+            db_.ToShadow(*shadow_, static_cast<uint32_t>(current_.location - start_));
+        }
+    } // UpdateShadow()
+
+
+    /**
+     * Locate valid internal data block ADT with given write counter on media and read it into internal
+     * data block.  All locations are checked by header.
+     *
+     * \param[in] counter write counter of required data block
+     * \retval true located and loaded
+     * \retval false not found
+     */
+    bool LocateCounter(const uint32_t counter) {
+        uint32_t *l = start_;
+        uint32_t i = ware_level_;
+
+        current_.loaded = false;
+        current_.location = 0;
+        if (db_.WillFit(media_, pages_) && i) {
+            do {
+                if (db_.ReadHeader(media_, l) && db_.GetCounter() == counter && db_.Read(media_, l)) {
+                    current_.loaded = true;
+                    current_.location = l;
+                    UpdateShadow();
+                    break;
+                }
+                l = GetNextLocation(l);
+            }while(--i>0);
+        }
+
+        return current_.loaded;
+    } // LocateCounter(...)
+
+
     /**
      * Get last storage or previous location from given location.  Used during loading to aid
      * finding a suitable block for use.
@@ -690,6 +1541,87 @@ protected:
     } // GetNextLocation(...)
 
 
+    /**
+     * Limit media without erase (FRAM, MRAM) to two slots used alternately.  No wear to level, cold load
+     * reads two headers and a save only writes Bytes changed since the copy before last
+     */
+    void SetEraseFreeProfile() {
+        if (!media_.NeedsErase() && ware_level_ > 2) {
+            pages_ = (pages_ / ware_level_) * 2;
+            ware_level_ = 2;
+        }
+    } // SetEraseFreeProfile()
+
+
+    /**
+     * Find slot for first save when not loaded.  Slot headers are scanned for the newest (CRC may be
+     * invalid), then the slot right after it is taken.  Locate only scans forward while counters are
+     * newer, a slot further along would not be found by a cold load
+     *
+     * \param[out] counter write counter to continue with, 0 when no header found
+     * \return Location
+     */
+    uint32_t* FindFirstSlot(uint32_t &counter) {
+        uint32_t *l = start_, *n = start_;
+        uint32_t c = 0, i;
+        bool s = false;
+
+        for(i = 0; i < ware_level_; i++, l = GetNextLocation(l)) {
+            if (db_.ReadHeader(media_, l) && (!s || H::IsNewer(db_.GetCounter(), c))) {
+                c = db_.GetCounter();
+                n = GetNextLocation(l);
+                s = true;
+            }
+        }
+
+        counter = s ? c + 1 : 0;
+
+        return n;
+    } // FindFirstSlot(...)
+
+
+#if defined(PERSISTSTRUCT_POINTERS)
+    /**
+     * Perform deferred lazy load, if any
+     */
+    void Resolve() {
+        if (pending_) {
+            pending_ = false;
+            Locate();
+        }
+    } // Resolve()
+
+
+    /**
+     * Query, is any data block header on media.  Headers only, no data block read or CRC check
+     *
+     * \retval true found
+     * \retval false storage empty
+     */
+    bool HasHeader() {
+        uint32_t *l = start_, i = pages_;
+        bool ok = false;
+
+        do {
+            ok = db_.ReadHeader(media_, l);
+            l = GetNextLocation(l);
+        }while(!ok && --i>0);
+
+        return ok;
+    } // HasHeader()
+#endif // PERSISTSTRUCT_POINTERS
+
+
+    /**
+     * Record current slot in attached hint store
+     */
+    void UpdateHint() {
+        if (hint_) {
+            hint_->Set(static_cast<uint16_t>((current_.location - start_) / struct_pages_u32_));
+        }
+    } // UpdateHint()
+
+
 protected:
     struct {
         bool        loaded;
@@ -701,6 +1633,13 @@ protected:
     uint32_t    pages_;
     uint32_t    ware_level_;
     Db            db_;
+    tShadow*    shadow_;
+    Hint*       hint_;
+    bool        slot_search_;       // First save slot search
+#if defined(PERSISTSTRUCT_POINTERS)
+    bool        lazy_;
+    bool        pending_;           // Lazy load deferred until Get
+#endif // PERSISTSTRUCT_POINTERS
 /*! \endcond */
 }; // class Struct
 
@@ -9,7 +9,8 @@
 #define SWCRC32_H
 
 namespace swimp {
-#if defined(ARDUINO_ARCH_STM32) && !defined(HAL_CRC_MODULE_ENABLED)
+#if (defined(ARDUINO_ARCH_STM32) && !defined(HAL_CRC_MODULE_ENABLED)) || \
+        (defined(__linux__) && !defined(ARDUINO_ARCH_STM32) && !defined(ARDUINO_ARCH_AVR))
 
 /**
  * A class offering s/w crc32 (CCITT polynomial)
@@ -0,0 +1,368 @@
+/**
+ * \file
+ * Persistent table of fixed size records, each record wear levelled independently
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Arduino, AVR, Maple Mini
+ */
+
+#ifndef PERSISTTABLE_H
+#define PERSISTTABLE_H
+
+#include "log.h"
+
+
+namespace persist {
+
+/*! \cond PRIVATE */
+/**
+ * Table record raw storage format, record index and ADT
+ */
+template<typename T>
+struct TableRecord {
+    uint16_t    index;
+    T           data;
+};
+/*! \endcond */
+
+
+/**
+ * A class offering persistent storage of a table of N user supplied structures (per channel
+ * calibration).  Records are held in memory, \ref Set marks a record dirty and \ref Commit writes only
+ * the dirty records.  Storage is log structured over a ring of pages (see \ref Log), each written
+ * record is appended with its index so changing one record costs one record write.
+ *
+ * \ref Load reads the region once in page order, the newest copy of each record wins.  When a page is
+ * opened the live records (newest copies) of the following page are relocated into it, so that page
+ * holds no live records by the time it is erased for reuse.
+ *
+ * \code
+ * persist::Table<cal_t, 64> g_cal(g_media, start, 4);
+ *
+ * g_cal.Load();
+ * cal_t c = g_cal.Get(ch);
+ * c.gain = 1.02f;
+ * g_cal.Set(ch, c);
+ * g_cal.Commit();
+ * \endcode
+ *
+ * \note Records not yet written are zero and reported by \ref IsPresent
+ * \attention Pages must be at least (N / \ref GetEntriesPerPage, rounded up) + 2.  More pages
+ * reduce relocation and wear
+ *
+ * \tparam T ADT type name of a record
+ * \tparam N record count
+ */
+template<typename T, uint16_t N>
+class Table : protected Log< TableRecord<T> > {
+public:
+    typedef TableRecord<T> tRecord;
+
+    /**
+     * Constructor based upon page count. You will have to load via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] pages N count, see class attention
+     */
+    Table(Media &m, uint32_t *start, uint16_t pages) : Log<tRecord>(m, start, pages) {
+        Reset();
+    } // Table(...)
+
+
+    /**
+     * Constructor based upon start and end pointers covering range for storage. You will have to
+     * load via \ref Load
+     *
+     * \param[in,out] m media instance reference
+     * \param[in] start page aligned location or offset into media.  Numeric may not represent
+     * a valid CPU address.
+     * \param[in] end location or offset into media.  Numeric may not represent a valid CPU address.
+     * Should be > start.
+     */
+    Table(Media &m, uint32_t *start, uint32_t *end) : Log<tRecord>(m, start, end) {
+        Reset();
+    } // Table(...)
+
+
+    /**
+     * Load table from media.  Single pass over written pages, oldest to newest, taking the newest
+     * valid copy of each record.  A relocation interrupted by power loss is completed.
+     *
+     * \retval true loaded, records may not be present
+     * \retval false table doesn't fit media pages
+     */
+    bool Load() {
+        tRecord r;
+        uint16_t k, p, i, n;
+        bool ok;
+
+        Reset();
+        ok = Log<tRecord>::Load();
+        if (ok && this->used_) {
+            for(k = 0, p = this->GetTailPage(); k < this->used_; k++, p = this->GetNextPage(p)) {
+                n = (p == this->head_page_) ? this->head_index_ : this->per_page_;
+                for(i = 0; i < n; i++) {
+                    if (this->Read(p, i, r) && r.index < N) {
+                        records_[r.index] = r.data;
+                        page_[r.index] = p;
+                    }
+                }
+            }
+
+            // Following page must hold no live records, complete relocation
+            if (this->used_ >= this->pages_) {
+                p = this->GetNextPage(this->head_page_);
+                for(i = 0; i < N; i++) {
+                    if (page_[i] == p) {
+                        SetDirty(i);
+                    }
+                }
+                ok = Commit();
+            }
+        }
+
+        return ok;
+    } // Load()
+
+
+    /**
+     * Get record
+     *
+     * \param[in] i record index, &lt; N
+     * \return Record reference, in memory copy
+     */
+    const T& Get(const uint16_t i) const {
+        return records_[(i < N) ? i : 0];
+    } // Get(...)
+
+
+    /**
+     * Set record.  Record is marked dirty when changed, use \ref Commit to write to media
+     *
+     * \param[in] i record index, &lt; N
+     * \param[in] data record ADT
+     * \retval true set
+     * \retval false index out of range
+     */
+    bool Set(const uint16_t i, const T &data) {
+        const uint8_t *a, *b;
+        uint32_t j;
+        bool ok = i < N;
+
+        if (ok) {
+            a = reinterpret_cast<const uint8_t*>(&records_[i]);
+            b = reinterpret_cast<const uint8_t*>(&data);
+            for(j = 0; j < sizeof(T); j++) {
+                if (a[j] != b[j]) {
+                    records_[i] = data;
+                    SetDirty(i);
+                    break;
+                }
+            }
+        }
+
+        return ok;
+    } // Set(...)
+
+
+    /**
+     * Write dirty records to media
+     *
+     * \retval true on success (including nothing to write)
+     * \retval false failed, records remain dirty
+     */
+    bool Commit() {
+        uint16_t i;
+        bool done = this->loaded_ || Load();
+
+        for(i = 0; done && i < N; i++) {
+            if (IsDirty(i)) {
+                done = Write(i);
+                if (done) {
+                    dirty_[i >> 3] &= static_cast<uint8_t>(~(1 << (i & 7)));
+                }
+            }
+        }
+
+        return done;
+    } // Commit()
+
+
+    /**
+     * Query, record changed since last \ref Commit
+     *
+     * \param[in] i record index
+     * \retval true dirty
+     * \retval false clean or index out of range
+     */
+    bool IsDirty(const uint16_t i) const {
+        return i < N && (dirty_[i >> 3] & (1 << (i & 7)));
+    } // IsDirty(...)
+
+
+    /**
+     * Query, record loaded from or written to media
+     *
+     * \param[in] i record index
+     * \retval true present
+     * \retval false not present or index out of range
+     */
+    bool IsPresent(const uint16_t i) const {
+        return i < N && page_[i] != NO_PAGE;
+    } // IsPresent(...)
+
+
+    using Log<tRecord>::IsLoaded;
+    using Log<tRecord>::GetEntriesPerPage;
+    using Log<tRecord>::GetEntrySize;
+
+/*! \cond PRIVATE */
+protected:
+    enum {
+        NO_PAGE = 0xffff
+    };
+
+
+    /**
+     * Clear in memory records, locations and dirty state
+     */
+    void Reset() {
+        uint8_t *b = reinterpret_cast<uint8_t*>(&records_[0]);
+        uint32_t i;
+
+        for(i = 0; i < sizeof(records_); i++) {
+            b[i] = 0;
+        }
+        for(i = 0; i < N; i++) {
+            page_[i] = NO_PAGE;
+        }
+        for(i = 0; i < sizeof(dirty_); i++) {
+            dirty_[i] = 0;
+        }
+    } // Reset()
+
+
+    void SetDirty(const uint16_t i) {
+        dirty_[i >> 3] |= static_cast<uint8_t>(1 << (i & 7));
+    } // SetDirty(...)
+
+
+    /**
+     * Write record at head, opening pages as required.  A relocation left incomplete by a failed write
+     * is resumed first
+     *
+     * \param[in] i record index
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Write(const uint16_t i) {
+        uint16_t n, o;
+        bool done = false;
+
+        for(n = 0; !done && n < (this->pages_ << 1); n++) {
+            o = page_[i];
+            if (this->used_) {
+                Relocate();
+            }
+            if (page_[i] == o && (!this->used_ || this->head_index_ >= this->per_page_)) {
+                if (!Advance()) {
+                    break;
+                }
+            }
+
+            // Relocation writes in memory copy, record may be written already
+            done = page_[i] != o || Put(i);
+        }
+
+        return done;
+    } // Write(...)
+
+
+    /**
+     * Write record at head.  Head page must have room
+     *
+     * \param[in] i record index
+     * \retval true on success
+     * \retval false failed
+     */
+    bool Put(const uint16_t i) {
+        tRecord r;
+        bool done;
+
+        r.index = i;
+        r.data = records_[i];
+        done = Log<tRecord>::Put(r);
+        if (done) {
+            page_[i] = this->head_page_;
+        }
+
+        return done;
+    } // Put(...)
+
+
+    /**
+     * Open next page and relocate live records of the page following it.  Live records left on the
+     * page to open are relocated into the head page first, refused when they don't fit
+     *
+     * \retval true opened, relocation may be left to resume
+     * \retval false page holds live records or erase failed
+     */
+    bool Advance() {
+        bool done = Relocate() && this->OpenPage();
+
+        if (done) {
+            // Relocated count is at most a page, fits opened page unless writes fail
+            Relocate();
+        }
+
+        return done;
+    } // Advance()
+
+
+    /**
+     * Relocate live records of the page following head into head page while it has room.  A failed
+     * write consuming an entry is retried.  When the page after that is full of live records one is
+     * moved too, so its relocation later leaves room for a failed write
+     *
+     * \retval true following page holds no live records
+     * \retval false head page full or write failed without consuming an entry
+     */
+    bool Relocate() {
+        uint16_t p = this->GetNextPage(this->head_page_), q = this->GetNextPage(p), i, k, live = 0;
+        bool done = true;
+
+        for(i = 0; done && i < N; i++) {
+            while(done && page_[i] == p) {
+                k = this->head_index_;
+                done = this->head_index_ < this->per_page_ && (Put(i) || this->head_index_ != k);
+            }
+        }
+
+        if (done && q != this->head_page_) {
+            for(i = 0; i < N; i++) {
+                if (page_[i] == q) {
+                    live++;
+                }
+            }
+            for(i = 0; live >= this->per_page_ && i < N && this->head_index_ < this->per_page_; i++) {
+                if (page_[i] == q && Put(i)) {
+                    live--;
+                }
+            }
+        }
+
+        return done;
+    } // Relocate()
+
+
+protected:
+    T           records_[N];        // In memory copy
+    uint16_t    page_[N];           // Page of newest copy
+    uint8_t     dirty_[(N + 7) / 8];
+/*! \endcond */
+}; // class Table
+
+} // namespace persist
+
+#endif // PERSISTTABLE_H
@@ -0,0 +1,404 @@
+/**
+ * \file
+ * Offline analyzer of raw flash or EEPROM dumps holding persist::Struct storage, for fleet diagnostics.
+ * Each dump is mapped (mmap) and every slot is decoded with the header policies of struct.h and the CRC
+ * engines of host/crc.h and sw/crc.h: valid, CRC failure, erased or other, write counters and which copy a
+ * Struct::Load would return.  Dumps (files, or every file of a directory) are analysed in parallel on all
+ * cores, a CSV or JSON summary row per dump goes to stdout.
+ *
+ * Build on Linux with any C++11 compiler, e.g. "g++ -O2 -pthread -I.. pstructdump.cpp -o pstructdump"
+ *
+ * \code
+ * pstructdump --block 52 --page 1024 --start 0xfc00 --slots 4 dumps/ > summary.csv
+ * \endcode
+ *
+ * Block size is Struct<T>::GetStorageUnitSize() of the firmware, slots are block size rounded up to
+ * pages as Struct lays them out.  Dumps are taken as little endian (AVR, STM32).
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Linux
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../media.h"
+#include "../struct.h"
+
+#include "../host/crc.h"
+
+// AVR CRC16 of sw/crc.h alongside host CRC32
+#define ARDUINO_ARCH_AVR
+#include "../sw/crc.h"
+#undef ARDUINO_ARCH_AVR
+
+
+/**
+ * Analysis options
+ */
+typedef struct {
+    uint32_t    block;          // Data block size, Struct<T>::GetStorageUnitSize()
+    uint32_t    page;           // Media page size
+    uint64_t    start;          // Storage offset in dump
+    uint32_t    slots;          // Ware levels, 0 all fitting dump
+    bool        compact;        // persist::HeadCompact headers
+    bool        crc16;          // AVR CRC16
+    bool        json;
+    uint32_t    jobs;
+}tOptions;
+
+/**
+ * Slot states
+ */
+enum {
+    SLOT_VALID = 'V',
+    SLOT_CRC = 'C',             // Sane header, CRC mismatch
+    SLOT_ERASED = 'E',
+    SLOT_OTHER = 'X'
+};
+
+/**
+ * Result of one dump
+ */
+typedef struct {
+    std::string             path;
+    std::string             error;
+    uint64_t                bytes;
+    uint32_t                valid;
+    uint32_t                crc_fail;
+    uint32_t                erased;
+    uint32_t                other;
+    int32_t                 newest;         // Newest valid slot, -1 none
+    uint32_t                newest_counter;
+    int32_t                 load;           // Slot Struct::Load returns, -1 none
+    uint32_t                load_counter;
+    std::string             state;          // Slot states
+    std::vector<uint32_t>   counter;        // Slot counters, sane headers only
+}tResult;
+
+
+/**
+ * CRC of data words as media Crc of the firmware
+ */
+static uint32_t Crc(const uint32_t *buffer, const uint32_t size_u32, const bool crc16) {
+    return crc16 ? swimp::Crc::Generate(buffer, size_u32) : hostimp::Crc::Generate(buffer, size_u32);
+}
+
+
+/**
+ * Decode slots of a mapped dump with header policy H, as Struct<T, H> would
+ *
+ * \param[in] p dump
+ * \param[in] o options
+ * \param[in,out] r result
+ */
+template<typename H>
+static void Analyse(const uint8_t *p, const tOptions &o, tResult &r) {
+    typedef typename H::tHead tHead;
+    uint64_t slot = ((o.block + o.page - 1) / o.page) * o.page;
+    uint32_t n = static_cast<uint32_t>((r.bytes - o.start) / slot), i, j, c = 0, crc;
+    bool erased, s = false;
+    tHead h;
+
+    if (o.slots && o.slots < n) {
+        n = o.slots;
+    }
+    r.state.resize(n);
+    r.counter.resize(n);
+    for(i = 0; i < n; i++) {
+        const uint8_t *b = p + o.start + i * slot;
+
+        memcpy(&h, b, sizeof(h));
+        for(j = 0, erased = true; erased && j < sizeof(h); j++) {
+            erased = b[j] == 0xff;
+        }
+        r.counter[i] = H::GetCounter(h);
+        if (erased) {
+            r.state[i] = SLOT_ERASED;
+            r.erased++;
+        }else if (!H::IsSane(h, o.block)) {
+            r.state[i] = SLOT_OTHER;
+            r.other++;
+        }else {
+            crc = Crc(reinterpret_cast<const uint32_t*>(b + sizeof(h)), (o.block - sizeof(h)) / sizeof(uint32_t), o.crc16);
+            if (H::IsSealed(h, crc, o.block)) {
+                r.state[i] = SLOT_VALID;
+                r.valid++;
+                if (r.newest < 0 || H::IsNewer(r.counter[i], r.newest_counter)) {
+                    r.newest = static_cast<int32_t>(i);
+                    r.newest_counter = r.counter[i];
+                }
+            }else {
+                r.state[i] = SLOT_CRC;
+                r.crc_fail++;
+            }
+        }
+    }
+
+    // Struct::Locate cold load, forward over sane headers while counters rise then back to a valid copy
+    for(i = 0, j = 0; n && i < n; i++) {
+        if (r.state[j] == SLOT_VALID || r.state[j] == SLOT_CRC) {
+            if (!s || H::IsNewer(r.counter[j], c)) {
+                c = r.counter[j];
+                j = (j + 1) % n;
+                s = true;
+            }else {
+                break;
+            }
+        }else {
+            j = (j + 1) % n;
+        }
+    }
+    for(i = 0; s && i < n; i++) {
+        j = (j + n - 1) % n;
+        if (r.state[j] == SLOT_VALID) {
+            r.load = static_cast<int32_t>(j);
+            r.load_counter = r.counter[j];
+            break;
+        }
+    }
+}
+
+
+/**
+ * Map and analyse one dump
+ *
+ * \param[in] o options
+ * \param[in,out] r result, path set
+ */
+static void AnalyseFile(const tOptions &o, tResult &r) {
+    struct stat st;
+    void *p = MAP_FAILED;
+    int fd = open(r.path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        r.error = "can't open";
+    }else if (static_cast<uint64_t>(st.st_size) < o.start + o.block) {
+        r.bytes = static_cast<uint64_t>(st.st_size);
+        r.error = "too small";
+    }else {
+        r.bytes = static_cast<uint64_t>(st.st_size);
+        p = mmap(NULL, r.bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            r.error = "can't map";
+        }else {
+            madvise(p, r.bytes, MADV_SEQUENTIAL);
+            if (o.compact) {
+                Analyse<persist::HeadCompact>(static_cast<const uint8_t*>(p), o, r);
+            }else {
+                Analyse<persist::HeadStd>(static_cast<const uint8_t*>(p), o, r);
+            }
+            munmap(p, r.bytes);
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+
+/**
+ * Add path, or regular files of directory sorted by name
+ *
+ * \param[in] path file or directory
+ * \param[in,out] results one added per file
+ */
+static void AddPath(const std::string &path, std::vector<tResult> &results) {
+    std::vector<std::string> names;
+    struct stat st;
+    struct dirent *e;
+    DIR *d;
+    tResult r;
+
+    r.bytes = 0;
+    r.valid = r.crc_fail = r.erased = r.other = 0;
+    r.newest = r.load = -1;
+    r.newest_counter = r.load_counter = 0;
+    if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && (d = opendir(path.c_str())) != NULL) {
+        while((e = readdir(d)) != NULL) {
+            std::string f = path + "/" + e->d_name;
+
+            if (stat(f.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+                names.push_back(f);
+            }
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+    }else {
+        names.push_back(path);
+    }
+    for(size_t i = 0; i < names.size(); i++) {
+        r.path = names[i];
+        results.push_back(r);
+    }
+}
+
+
+/**
+ * Quote string for CSV or JSON
+ */
+static std::string Quote(const std::string &s) {
+    std::string q = "\"";
+
+    for(size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\') {
+            q+= '\\';
+        }
+        q+= s[i];
+    }
+
+    return q + "\"";
+}
+
+
+static void Print(const tResult &r, const bool json, const bool first) {
+    size_t i;
+
+    if (json) {
+        std::cout << (first ? "[\n" : ",\n") << "{\"file\":" << Quote(r.path) << ",\"bytes\":" << r.bytes <<
+            ",\"slots\":" << r.state.size() << ",\"valid\":" << r.valid << ",\"crc_fail\":" << r.crc_fail <<
+            ",\"erased\":" << r.erased << ",\"other\":" << r.other << ",\"newest_slot\":" << r.newest <<
+            ",\"newest_counter\":" << r.newest_counter << ",\"load_slot\":" << r.load << ",\"load_counter\":" <<
+            r.load_counter << ",\"state\":" << Quote(r.state) << ",\"counters\":[";
+        for(i = 0; i < r.state.size(); i++) {
+            std::cout << (i ? "," : "");
+            if (r.state[i] == SLOT_VALID || r.state[i] == SLOT_CRC) {
+                std::cout << r.counter[i];
+            }else {
+                std::cout << "null";
+            }
+        }
+        std::cout << "],\"error\":" << Quote(r.error) << "}";
+    }else {
+        if (first) {
+            std::cout << "file,bytes,slots,valid,crc_fail,erased,other,newest_slot,newest_counter,load_slot," \
+                            "load_counter,history,error\n";
+        }
+        std::cout << Quote(r.path) << "," << r.bytes << "," << r.state.size() << "," << r.valid << "," <<
+            r.crc_fail << "," << r.erased << "," << r.other << "," << r.newest << "," << r.newest_counter << "," <<
+            r.load << "," << r.load_counter << ",";
+
+        // Counter per slot, ! CRC failure, - no header
+        for(i = 0; i < r.state.size(); i++) {
+            std::cout << (i ? ";" : "");
+            if (r.state[i] == SLOT_VALID || r.state[i] == SLOT_CRC) {
+                std::cout << r.counter[i] << (r.state[i] == SLOT_CRC ? "!" : "");
+            }else {
+                std::cout << (r.state[i] == SLOT_ERASED ? "e" : "-");
+            }
+        }
+        std::cout << "," << Quote(r.error) << "\n";
+    }
+}
+
+
+static void Usage() {
+    std::cerr << "usage: pstructdump --block BYTES [options] DUMP|DIR...\n"
+        "  --block BYTES   data block size, Struct<T>::GetStorageUnitSize()\n"
+        "  --page BYTES    media page size, default 1024\n"
+        "  --start BYTES   storage offset in dump, default 0\n"
+        "  --slots N       ware levels, default all fitting dump\n"
+        "  --compact       persist::HeadCompact headers\n"
+        "  --crc16         AVR CRC16, default CRC32\n"
+        "  --json          JSON rather than CSV\n"
+        "  -j N            threads, default all cores\n";
+}
+
+
+/**
+ * Entry point
+ *
+ * @return int Status
+ * @retval 0 Success
+ * @retval 1 Bad arguments
+ * @retval 2 A dump could not be analysed
+ */
+int main(int argc, char *argv[]) {
+    tOptions o;
+    std::vector<tResult> results;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next(0);
+    uint64_t total = 0;
+    int i, status = 0;
+
+    o.block = 0;
+    o.page = 1024;
+    o.start = 0;
+    o.slots = 0;
+    o.compact = o.crc16 = o.json = false;
+    o.jobs = std::thread::hardware_concurrency();
+    for(i = 1; i < argc; i++) {
+        std::string a = argv[i];
+
+        if ((a == "--block" || a == "--page" || a == "--start" || a == "--slots" || a == "-j") && i + 1 < argc) {
+            uint64_t v = strtoull(argv[++i], NULL, 0);
+
+            if (a == "--block") o.block = static_cast<uint32_t>(v);
+            else if (a == "--page") o.page = static_cast<uint32_t>(v);
+            else if (a == "--start") o.start = v;
+            else if (a == "--slots") o.slots = static_cast<uint32_t>(v);
+            else o.jobs = static_cast<uint32_t>(v);
+        }else if (a == "--compact") {
+            o.compact = true;
+        }else if (a == "--crc16") {
+            o.crc16 = true;
+        }else if (a == "--json") {
+            o.json = true;
+        }else if (a[0] == '-') {
+            Usage();
+            return 1;
+        }else {
+            AddPath(a, results);
+        }
+    }
+    if (!o.block || o.block % sizeof(uint32_t) || !o.page || o.start % sizeof(uint32_t) || results.empty()) {
+        Usage();
+        return 1;
+    }
+    if (!o.jobs) {
+        o.jobs = 1;
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for(uint32_t j = 0; j < o.jobs && j < results.size(); j++) {
+        workers.push_back(std::thread([&]() {
+            size_t k;
+
+            while((k = next++) < results.size()) {
+                AnalyseFile(o, results[k]);
+            }
+        }));
+    }
+    for(size_t j = 0; j < workers.size(); j++) {
+        workers[j].join();
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    for(size_t j = 0; j < results.size(); j++) {
+        Print(results[j], o.json, !j);
+        total+= results[j].bytes;
+        if (!results[j].error.empty()) {
+            status = 2;
+        }
+    }
+    if (o.json) {
+        std::cout << "\n]\n";
+    }
+    fprintf(stderr, "%u dumps, %.1f MB, %u threads, %.3f s, %.0f MB/s\n", static_cast<unsigned>(results.size()),
+                total / 1e6, static_cast<unsigned>(workers.size()), s, (s > 0) ? total / 1e6 / s : 0.0);
+
+    return status;
+} // main()
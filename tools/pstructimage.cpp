@@ -0,0 +1,355 @@
+/**
+ * \file
+ * Factory image generator for pre-provisioned persist::Struct storage.  Each row of an input table holds
+ * a unit name and the raw bytes of its ADT &lt;T&gt;, a ready to flash storage region image with sealed
+ * headers and CRCs is written per unit, so settings are flashed together with the firmware rather than
+ * saved on the line.  Images are generated in parallel on all cores, each streamed to disk slot by slot.
+ *
+ * Build on Linux with any C++11 compiler, e.g. "g++ -O2 -pthread -I.. pstructimage.cpp -o pstructimage"
+ *
+ * \code
+ * pstructimage --size 40 --page 1024 --slots 4 --copies 2 units.txt images/
+ * \endcode
+ *
+ * Table rows are "name hex", name gives the image file (name.bin), hex is sizeof(T) Bytes of T as laid
+ * out by the target compiler (little endian, padding included).  Blank lines and lines starting # are
+ * skipped, a comma may separate the columns.
+ *
+ * Layout: region of slots (block size rounded up to pages, as Struct lays them out), the value is
+ * written to copies consecutive slots from first with counters 0, 1, ... and the rest left in erase
+ * state.  Struct::Load returns the last copy and falls back to the earlier ones, the first save of the
+ * unit goes to the slot after it.  Images read back with tools/pstructdump.cpp.
+ * PROJECT: PStruct library
+ * TARGET SYSTEM: Linux
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../media.h"
+#include "../struct.h"
+
+#include "../host/crc.h"
+
+// AVR CRC16 of sw/crc.h alongside host CRC32
+#define ARDUINO_ARCH_AVR
+#include "../sw/crc.h"
+#undef ARDUINO_ARCH_AVR
+
+
+/**
+ * Generation options
+ */
+typedef struct {
+    uint32_t    size;           // sizeof(T)
+    uint32_t    page;           // Media page size
+    uint32_t    slots;          // Ware levels, slots in region
+    uint32_t    first;          // First slot written
+    uint32_t    copies;         // Slots written with the value
+    uint8_t     fill;           // Media erase state
+    bool        compact;        // persist::HeadCompact headers
+    bool        crc16;          // AVR CRC16
+    uint32_t    jobs;
+    std::string out;            // Output directory
+}tOptions;
+
+/**
+ * Table row
+ */
+typedef struct {
+    std::string             name;
+    std::vector<uint8_t>    data;           // T
+    std::string             error;
+}tUnit;
+
+
+/**
+ * CRC of data words as media Crc of the firmware
+ */
+static uint32_t Crc(const uint32_t *buffer, const uint32_t size_u32, const bool crc16) {
+    return crc16 ? swimp::Crc::Generate(buffer, size_u32) : hostimp::Crc::Generate(buffer, size_u32);
+}
+
+
+/**
+ * Get data block size of header policy H, Struct<T, H>::GetStorageUnitSize()
+ *
+ * \param[in] size sizeof(T)
+ * \return Bytes
+ */
+template<typename H>
+static uint32_t GetBlockSize(const uint32_t size) {
+    return ((sizeof(typename H::tHead) + size + sizeof(uint32_t) - 1) / sizeof(uint32_t)) * sizeof(uint32_t);
+}
+
+
+/**
+ * Build data block with header policy H, as Struct<T, H> saves it.  Padding after T is erase state as
+ * Struct leaves it
+ *
+ * \param[in] o options
+ * \param[in] u unit
+ * \param[in] counter write counter
+ * \param[out] block data block, slot sized
+ */
+template<typename H>
+static void Build(const tOptions &o, const tUnit &u, const uint32_t counter, std::vector<uint32_t> &block) {
+    typedef typename H::tHead tHead;
+    uint32_t bytes = GetBlockSize<H>(o.size);
+    uint8_t *b = reinterpret_cast<uint8_t*>(&block[0]);
+    tHead h;
+
+    memset(b, o.fill, block.size() * sizeof(uint32_t));
+    memset(b + sizeof(h), 0xff, bytes - sizeof(h));
+    memcpy(b + sizeof(h), &u.data[0], o.size);
+    H::Clear(h);
+    H::SetCounter(h, counter);
+    H::Seal(h, Crc(&block[sizeof(h) / sizeof(uint32_t)], (bytes - sizeof(h)) / sizeof(uint32_t), o.crc16), bytes);
+    memcpy(b, &h, sizeof(h));
+}
+
+
+/**
+ * Generate and stream region image of one unit
+ *
+ * \param[in] o options
+ * \param[in,out] u unit, error set on failure
+ * \return Bytes written
+ */
+template<typename H>
+static uint64_t Generate(const tOptions &o, tUnit &u) {
+    uint32_t bytes = GetBlockSize<H>(o.size), slot = ((bytes + o.page - 1) / o.page) * o.page, i;
+    std::vector<uint32_t> block(slot / sizeof(uint32_t)), erased(slot / sizeof(uint32_t));
+    std::string path = o.out + "/" + u.name + ".bin";
+    uint64_t total = 0;
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    memset(&erased[0], o.fill, slot);
+    for(i = 0; fd >= 0 && u.error.empty() && i < o.slots; i++) {
+        const uint32_t *p = &erased[0];
+
+        // Slot i holds copy (i - first) when among the copies
+        if ((i + o.slots - o.first) % o.slots < o.copies) {
+            Build<H>(o, u, (i + o.slots - o.first) % o.slots, block);
+            p = &block[0];
+        }
+        if (write(fd, p, slot) == static_cast<ssize_t>(slot)) {
+            total+= slot;
+        }else {
+            u.error = "can't write";
+        }
+    }
+    if (fd < 0) {
+        u.error = "can't create";
+    }else if (close(fd) != 0 && u.error.empty()) {
+        u.error = "can't write";
+    }
+
+    return total;
+}
+
+
+/**
+ * Parse hex Bytes
+ *
+ * \param[in] s hex digits, even count
+ * \param[out] data Bytes
+ * \retval true parsed
+ * \retval false not hex
+ */
+static bool ParseHex(const std::string &s, std::vector<uint8_t> &data) {
+    bool ok = !(s.size() % 2);
+
+    data.clear();
+    for(size_t i = 0; ok && i < s.size(); i+= 2) {
+        char *e;
+        std::string d = s.substr(i, 2);
+        unsigned long v = strtoul(d.c_str(), &e, 16);
+
+        ok = !*e && isxdigit(static_cast<unsigned char>(d[0]));
+        data.push_back(static_cast<uint8_t>(v));
+    }
+
+    return ok;
+}
+
+
+/**
+ * Read table
+ *
+ * \param[in] path table file
+ * \param[in] o options
+ * \param[out] units one per row, row errors set in unit
+ * \retval true read
+ * \retval false can't open
+ */
+static bool ReadTable(const char *path, const tOptions &o, std::vector<tUnit> &units) {
+    std::ifstream f(path);
+    std::string line;
+    uint32_t row = 0;
+
+    while(f && std::getline(f, line)) {
+        size_t a, b, c, d;
+        tUnit u;
+
+        row++;
+        for(size_t i = 0; i < line.size(); i++) {
+            if (line[i] == ',' || line[i] == '\t' || line[i] == '\r') {
+                line[i] = ' ';
+            }
+        }
+        a = line.find_first_not_of(' ');
+        if (a == std::string::npos || line[a] == '#') {
+            continue;
+        }
+        b = line.find(' ', a);
+        c = (b == std::string::npos) ? b : line.find_first_not_of(' ', b);
+        d = (c == std::string::npos) ? c : line.find(' ', c);
+        u.name = line.substr(a, (b == std::string::npos) ? b : b - a);
+        if (c == std::string::npos || (d != std::string::npos && line.find_first_not_of(' ', d) != std::string::npos)) {
+            u.error = "row " + std::to_string(row) + ": expected name and hex";
+        }else if (u.name.find('/') != std::string::npos || u.name == "." || u.name == "..") {
+            u.error = "row " + std::to_string(row) + ": bad name";
+        }else if (!ParseHex(line.substr(c, (d == std::string::npos) ? d : d - c), u.data)) {
+            u.error = "row " + std::to_string(row) + ": bad hex";
+        }else if (u.data.size() != o.size) {
+            u.error = "row " + std::to_string(row) + ": " + std::to_string(u.data.size()) + " Bytes, expected " +
+                        std::to_string(o.size);
+        }
+        units.push_back(u);
+    }
+
+    return f.eof();
+}
+
+
+static void Usage() {
+    std::cerr << "usage: pstructimage --size BYTES [options] TABLE OUTDIR\n"
+        "  --size BYTES    sizeof(T)\n"
+        "  --page BYTES    media page size, default 1024\n"
+        "  --slots N       ware levels, default 2\n"
+        "  --first N       first slot written, default 0\n"
+        "  --copies N      slots written with the value, default 1\n"
+        "  --fill BYTE     media erase state, default 0xff\n"
+        "  --compact       persist::HeadCompact headers\n"
+        "  --crc16         AVR CRC16, default CRC32\n"
+        "  -j N            threads, default all cores\n";
+}
+
+
+/**
+ * Entry point
+ *
+ * @return int Status
+ * @retval 0 Success
+ * @retval 1 Bad arguments or table
+ * @retval 2 An image could not be written
+ */
+int main(int argc, char *argv[]) {
+    tOptions o;
+    std::vector<tUnit> units;
+    std::vector<std::thread> workers;
+    std::vector<std::string> paths;
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> total(0);
+    uint32_t block;
+    int i, status = 0;
+
+    o.size = 0;
+    o.page = 1024;
+    o.slots = 2;
+    o.first = 0;
+    o.copies = 1;
+    o.fill = 0xff;
+    o.compact = o.crc16 = false;
+    o.jobs = std::thread::hardware_concurrency();
+    for(i = 1; i < argc; i++) {
+        std::string a = argv[i];
+
+        if ((a == "--size" || a == "--page" || a == "--slots" || a == "--first" || a == "--copies" || a == "--fill" ||
+                a == "-j") && i + 1 < argc) {
+            uint32_t v = static_cast<uint32_t>(strtoul(argv[++i], NULL, 0));
+
+            if (a == "--size") o.size = v;
+            else if (a == "--page") o.page = v;
+            else if (a == "--slots") o.slots = v;
+            else if (a == "--first") o.first = v;
+            else if (a == "--copies") o.copies = v;
+            else if (a == "--fill") o.fill = static_cast<uint8_t>(v);
+            else o.jobs = v;
+        }else if (a == "--compact") {
+            o.compact = true;
+        }else if (a == "--crc16") {
+            o.crc16 = true;
+        }else if (a[0] == '-') {
+            Usage();
+            return 1;
+        }else {
+            paths.push_back(a);
+        }
+    }
+
+    // Copies wrapping onto themselves or more than a compact counter orders aren't loadable
+    if (!o.size || !o.page || !o.slots || o.first >= o.slots || !o.copies || o.copies > o.slots ||
+            o.copies > 0x7fff || paths.size() != 2) {
+        Usage();
+        return 1;
+    }
+    if (!o.jobs) {
+        o.jobs = 1;
+    }
+    o.out = paths[1];
+    if (!ReadTable(paths[0].c_str(), o, units)) {
+        std::cerr << "pstructimage: can't read " << paths[0] << std::endl;
+        return 1;
+    }
+    for(size_t j = 0, n = 0; j < units.size(); j++) {
+        if (!units[j].error.empty() && n++ < 10) {
+            std::cerr << "pstructimage: " << units[j].error << std::endl;
+            status = 1;
+        }
+    }
+    if (status) {
+        return status;
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for(uint32_t j = 0; j < o.jobs && j < units.size(); j++) {
+        workers.push_back(std::thread([&]() {
+            size_t k;
+
+            while((k = next++) < units.size()) {
+                total+= o.compact ? Generate<persist::HeadCompact>(o, units[k]) : Generate<persist::HeadStd>(o, units[k]);
+            }
+        }));
+    }
+    for(size_t j = 0; j < workers.size(); j++) {
+        workers[j].join();
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    for(size_t j = 0, n = 0; j < units.size(); j++) {
+        if (!units[j].error.empty() && n++ < 10) {
+            std::cerr << "pstructimage: " << units[j].name << ": " << units[j].error << std::endl;
+            status = 2;
+        }
+    }
+    block = o.compact ? GetBlockSize<persist::HeadCompact>(o.size) : GetBlockSize<persist::HeadStd>(o.size);
+    fprintf(stderr, "%u images, block %u, slot %u, %.1f MB, %u threads, %.3f s\n", static_cast<unsigned>(units.size()),
+                static_cast<unsigned>(block), static_cast<unsigned>(((block + o.page - 1) / o.page) * o.page),
+                total / 1e6, static_cast<unsigned>(workers.size()), s);
+
+    return status;
+} // main()